@@ -0,0 +1,92 @@
+/*
+ * Author: Noah Laforet
+ * Lock-free single-producer/single-consumer edge event queue
+ *
+ * The sampling task is the only writer of `head` and the decoder task is the
+ * only writer of `tail`, so pushes and pops need nothing more than
+ * acquire/release ordering on those two indices. No read-modify-write atomics
+ * are used: the ESP32-C3 core has no RISC-V "A" extension, and plain aligned
+ * 32-bit loads/stores with fences are lock-free on it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define EDGE_QUEUE_LEN      256     // Must be a power of two
+#define EDGE_QUEUE_MASK     (EDGE_QUEUE_LEN - 1)
+
+_Static_assert((EDGE_QUEUE_LEN & EDGE_QUEUE_MASK) == 0, "EDGE_QUEUE_LEN must be a power of two");
+
+typedef enum {
+    EDGE_EVENT_RISE,    // Light turned ON
+    EDGE_EVENT_FALL,    // Light turned OFF
+    EDGE_EVENT_TICK,    // No edge; carries the sample clock forward for timeouts
+} edge_event_type_t;
+
+typedef struct {
+    int64_t time_us;    // Sample-clock timestamp (microseconds, for data mode)
+    uint8_t type;       // edge_event_type_t
+    uint8_t channel;    // Receiver channel (photodiode) the event belongs to
+} edge_event_t;
+
+_Static_assert(sizeof(edge_event_t) == 16, "edge_event_t must stay 16 bytes (EDGE_QUEUE_LEN of them in RAM)");
+
+typedef struct {
+    edge_event_t events[EDGE_QUEUE_LEN];
+    atomic_uint head;               // Next slot to write (producer only)
+    atomic_uint tail;               // Next slot to read (consumer only)
+    atomic_uint overflow_count;     // Events dropped because the queue was full (producer only)
+} edge_queue_t;
+
+static inline void edge_queue_init(edge_queue_t *q)
+{
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->overflow_count, 0);
+}
+
+// Producer side. Returns false (and counts an overflow) if the queue is full.
+static inline bool edge_queue_push(edge_queue_t *q, const edge_event_t *event)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    if (head - tail >= EDGE_QUEUE_LEN) {
+        unsigned dropped = atomic_load_explicit(&q->overflow_count, memory_order_relaxed);
+        atomic_store_explicit(&q->overflow_count, dropped + 1, memory_order_relaxed);
+        return false;
+    }
+
+    q->events[head & EDGE_QUEUE_MASK] = *event;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Consumer side. Returns false if the queue is empty.
+static inline bool edge_queue_pop(edge_queue_t *q, edge_event_t *event)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *event = q->events[tail & EDGE_QUEUE_MASK];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Either side; a snapshot that may be stale by the time it returns
+static inline bool edge_queue_empty(edge_queue_t *q)
+{
+    return atomic_load_explicit(&q->head, memory_order_acquire) == atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+static inline unsigned edge_queue_overflow_count(edge_queue_t *q)
+{
+    return atomic_load_explicit(&q->overflow_count, memory_order_relaxed);
+}
@@ -0,0 +1,133 @@
+/*
+ * Author: Noah Laforet
+ * Deferred binary event log
+ *
+ * Decoder events are written here as fixed-size records in O(1) and turned
+ * into text later by a low-priority log task, so a slow UART never holds up
+ * decoding. Same single-producer/single-consumer scheme as edge_queue.h: the
+ * decoder task only writes `head`, the log task only writes `tail`. When the
+ * log task falls behind, new records are dropped and counted rather than
+ * blocking the decoder.
+ *
+ * Text too long for a record (pages, frame payloads) goes in a slot of an
+ * event_log_slots_t pool that the record indexes. The producer claims the
+ * next slot before writing and the consumer releases it once printed, so a
+ * slot is never reused while its record is queued; with every slot still
+ * held the record is dropped and counted like a full ring.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define EVENT_LOG_LEN       512     // Must be a power of two
+#define EVENT_LOG_MASK      (EVENT_LOG_LEN - 1)
+
+_Static_assert((EVENT_LOG_LEN & EVENT_LOG_MASK) == 0, "EVENT_LOG_LEN must be a power of two");
+
+typedef struct {
+    int64_t time_us;        // Decoder timestamp
+    int32_t duration_us;    // Pulse/gap length (clamped), or the dot estimate for messages
+    uint8_t type;           // morse_event_type_t, or a log-only type defined by the front end
+    uint8_t index;          // Tree index (characters) or page slot (output text)
+    char ch;                // Decoded character
+    uint8_t channel;        // Receiver channel that produced the record
+} event_log_record_t;
+
+_Static_assert(sizeof(event_log_record_t) == 16, "event_log_record_t must stay 16 bytes (EVENT_LOG_LEN of them in RAM)");
+
+typedef struct {
+    event_log_record_t records[EVENT_LOG_LEN];
+    atomic_uint head;               // Next slot to write (decoder task only)
+    atomic_uint tail;               // Next slot to read (log task only)
+    atomic_uint dropped_count;      // Records lost because the ring was full (decoder task only)
+} event_log_t;
+
+static inline void event_log_init(event_log_t *log)
+{
+    atomic_init(&log->head, 0);
+    atomic_init(&log->tail, 0);
+    atomic_init(&log->dropped_count, 0);
+}
+
+// Producer side. Returns false (and counts a drop) if the ring is full.
+static inline bool event_log_write(event_log_t *log, const event_log_record_t *record)
+{
+    unsigned head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&log->tail, memory_order_acquire);
+
+    if (head - tail >= EVENT_LOG_LEN) {
+        unsigned dropped = atomic_load_explicit(&log->dropped_count, memory_order_relaxed);
+        atomic_store_explicit(&log->dropped_count, dropped + 1, memory_order_relaxed);
+        return false;
+    }
+
+    log->records[head & EVENT_LOG_MASK] = *record;
+    atomic_store_explicit(&log->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Consumer side. Returns false if the ring is empty.
+static inline bool event_log_read(event_log_t *log, event_log_record_t *record)
+{
+    unsigned tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&log->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *record = log->records[tail & EVENT_LOG_MASK];
+    atomic_store_explicit(&log->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Either side; a snapshot that may be stale by the time it returns
+static inline bool event_log_empty(event_log_t *log)
+{
+    return atomic_load_explicit(&log->head, memory_order_acquire) == atomic_load_explicit(&log->tail, memory_order_acquire);
+}
+
+static inline unsigned event_log_dropped_count(event_log_t *log)
+{
+    return atomic_load_explicit(&log->dropped_count, memory_order_relaxed);
+}
+
+// Claims and releases of one pool of payload slots; zero-initialised is empty
+typedef struct {
+    unsigned claimed;               // Records written that hold a slot (producer only)
+    atomic_uint released;           // Slots the consumer is done with (consumer only)
+} event_log_slots_t;
+
+// Producer side. The slot (of `count`, a power of two) for the next record
+// of this pool, or -1 (counting a drop) while the consumer still holds them all.
+static inline int event_log_slot_next(event_log_t *log, event_log_slots_t *slots, unsigned count)
+{
+    if (slots->claimed - atomic_load_explicit(&slots->released, memory_order_acquire) >= count) {
+        unsigned dropped = atomic_load_explicit(&log->dropped_count, memory_order_relaxed);
+        atomic_store_explicit(&log->dropped_count, dropped + 1, memory_order_relaxed);
+        return -1;
+    }
+    return (int)(slots->claimed & (count - 1));
+}
+
+// Producer side: event_log_write() for a record using the slot from
+// event_log_slot_next(), which stays claimed only if the record got in.
+static inline bool event_log_write_slot(event_log_t *log, event_log_slots_t *slots, const event_log_record_t *record)
+{
+    if (!event_log_write(log, record)) {
+        return false;
+    }
+    slots->claimed++;
+    return true;
+}
+
+// Consumer side: done with the oldest claimed slot. Records are read in
+// order, so that is the one of the record just handled.
+static inline void event_log_slot_release(event_log_slots_t *slots)
+{
+    unsigned released = atomic_load_explicit(&slots->released, memory_order_relaxed);
+    atomic_store_explicit(&slots->released, released + 1, memory_order_release);
+}
@@ -0,0 +1,87 @@
+/*
+ * Author: Noah Laforet
+ * Raw ADC capture blocks
+ *
+ * Capture mode (CONFIG_MORSE_CAPTURE) sends every photodiode sample, or the
+ * mean of every `decimation` samples, to the host so a failed decode can be
+ * replayed offline (host/morse_replay.c). Samples go out in blocks, one
+ * channel each, little-endian:
+ *
+ *   offset  size
+ *   0       2      sync "MC"
+ *   2       1      MORSE_CAPTURE_VERSION
+ *   3       1      channel
+ *   4       2      N, samples in the block (<= MORSE_CAPTURE_BLOCK_SAMPLES)
+ *   6       2      decimation (1: every sample)
+ *   8       4      sample rate of the block's samples (after decimation), Hz
+ *   12      4      index of the first sample on the channel's capture clock
+ *   16      2      blocks of this channel lost just before this one
+ *   18      3N/2   12-bit samples a, b packed in pairs as a[7:0], a[11:8] | b[3:0] << 4, b[11:4]
+ *   ...     2      CRC-16/CCITT-FALSE over everything before it
+ *
+ * The capture clock counts from the first sample captured, calibration
+ * included, so a lost block shows up as a jump in the index. The blocks share
+ * the console with log text; a reader finds them by the sync bytes and keeps
+ * those whose CRC matches.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MORSE_CAPTURE_VERSION           1
+#define MORSE_CAPTURE_BLOCK_SAMPLES     256     // Even: samples pack in pairs
+#define MORSE_CAPTURE_HEADER_BYTES      18
+#define MORSE_CAPTURE_CRC_BYTES         2
+#define MORSE_CAPTURE_BLOCK_MAX         (MORSE_CAPTURE_HEADER_BYTES + MORSE_CAPTURE_BLOCK_SAMPLES * 3 / 2 + \
+                                         MORSE_CAPTURE_CRC_BYTES)
+#define MORSE_CAPTURE_SAMPLE_MAX        4095
+
+typedef struct {
+    uint8_t channel;
+    uint16_t count;
+    uint16_t decimation;
+    uint32_t sample_freq_hz;
+    uint32_t first_sample;
+    uint16_t dropped;
+    uint16_t samples[MORSE_CAPTURE_BLOCK_SAMPLES];
+} morse_capture_block_t;
+
+// One channel's block being filled
+typedef struct {
+    morse_capture_block_t block;
+    uint32_t sum;                   // Raw samples averaged into the next one
+    uint16_t summed;
+    uint16_t unsent_dropped;        // block.dropped of the block last packed
+    uint32_t next_sample;           // Capture clock
+} morse_capture_t;
+
+void morse_capture_init(morse_capture_t *capture, uint8_t channel, uint32_t sample_freq_hz, uint16_t decimation);
+
+// One raw sample; true once the block is full and must be packed
+static inline bool morse_capture_add(morse_capture_t *capture, int32_t raw)
+{
+    capture->sum += (uint32_t)raw;
+    if (++capture->summed < capture->block.decimation) {
+        return false;
+    }
+    capture->block.samples[capture->block.count++] = (uint16_t)(capture->sum / capture->summed);
+    capture->sum = 0;
+    capture->summed = 0;
+    return capture->block.count == MORSE_CAPTURE_BLOCK_SAMPLES;
+}
+
+// Serialise the full block into out (MORSE_CAPTURE_BLOCK_MAX bytes) without
+// its CRC and start the next one. Returns the bytes written.
+size_t morse_capture_pack(morse_capture_t *capture, uint8_t *out);
+
+// The block just packed could not be sent: the next one reports it lost
+void morse_capture_drop(morse_capture_t *capture);
+
+// Append the CRC to a packed block, off the sampling path. Returns the block length.
+size_t morse_capture_seal(uint8_t *block, size_t length);
+
+// A valid block at data[0..available): fills block and returns its length, or 0
+size_t morse_capture_unpack(const uint8_t *data, size_t available, morse_capture_block_t *block);
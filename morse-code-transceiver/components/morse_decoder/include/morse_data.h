@@ -0,0 +1,97 @@
+/*
+ * Author: Noah Laforet
+ * Data mode: Manchester-coded bursts on the same LED and photodiode
+ *
+ * Morse needs 3- and 7-unit gaps and variable-length letters, so it averages
+ * well under one bit per dot time. A data burst is a fixed-rate Manchester
+ * line code instead (IEEE 802.3 convention: 0 = ON then OFF, 1 = OFF then ON,
+ * so every bit has a mid-bit edge to recover the clock from):
+ *
+ *   <SN>  preamble  sync  LL  payload  CCCC
+ *
+ *   <SN>       ...-.  sent as ordinary Morse; the decoder reports it as
+ *              MORSE_DATA_START and the receiver switches to this bit slicer
+ *   preamble   32 zero bits: an edge every half bit, the receiver measures
+ *              the half-bit time from it (no rate is configured)
+ *   sync       16 bits, MORSE_DATA_SYNC_WORD
+ *   LL         payload length in bytes
+ *   payload    LL bytes, MSB first
+ *   CCCC       CRC-16/CCITT-FALSE over LL and the payload, big-endian
+ *
+ * After the CRC (or when the clock is lost) the receiver goes back to Morse.
+ * Bits are timed from the edge and tick timestamps the front end passes in,
+ * in microseconds. The encoder is transmitter/src/morse_data.py.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MORSE_DATA_START            '\x16'  // <SN> prosign
+#define MORSE_DATA_SYNC_WORD        0xD391
+#define MORSE_DATA_PAYLOAD_MAX      255
+#define MORSE_DATA_TRAINING_EDGES   8       // Half-bit intervals averaged before bits are sliced
+#define MORSE_DATA_HUNT_BITS        128     // Bits to find the sync word in before giving up
+
+typedef enum {
+    MORSE_DATA_OK,
+    MORSE_DATA_BAD_CRC,
+    MORSE_DATA_NO_SYNC,         // No preamble or sync word after <SN>
+    MORSE_DATA_LOST_CLOCK,      // Edges stopped fitting the bit clock mid-frame
+} morse_data_status_t;
+
+typedef struct {
+    morse_data_status_t status;
+    uint8_t length;             // Bytes received
+    int32_t half_bit_us;        // Recovered clock
+    int64_t duration_us;        // First preamble edge to last bit
+    const uint8_t *payload;     // Valid during the callback only
+} morse_data_frame_t;
+
+typedef void (*morse_data_cb_t)(const morse_data_frame_t *frame, void *ctx);
+
+typedef enum {
+    MORSE_DATA_IDLE,            // Morse mode
+    MORSE_DATA_ARMED,           // <SN> seen, waiting for the preamble
+    MORSE_DATA_TRAINING,        // Measuring the half-bit time
+    MORSE_DATA_HUNTING,         // Slicing bits, looking for the sync word
+    MORSE_DATA_RECEIVING,       // Slicing bytes
+    MORSE_DATA_TRAILER,         // Frame reported, waiting for the light to settle
+} morse_data_state_t;
+
+typedef struct {
+    morse_data_state_t state;
+    int64_t armed_us;
+    int64_t timeout_us;         // ARMED: give up if no preamble by then
+    int64_t first_edge_us;
+    int64_t last_edge_us;
+    int64_t last_mid_us;        // Last mid-bit edge (the bit clock phase)
+    int64_t training_sum_us;
+    uint16_t training_count;
+    int32_t half_bit_us;
+    bool boundary;              // A bit-boundary edge came after last_mid_us
+    uint16_t shift;             // Last 16 bits (sync search)
+    uint16_t bits;              // Bits sliced in the current state
+    uint16_t count;             // Bytes received: LL, payload, CRC
+    uint8_t buffer[1 + MORSE_DATA_PAYLOAD_MAX + 2];
+    uint32_t frames_ok;
+    uint32_t frames_bad;
+    morse_data_cb_t callback;
+    void *callback_ctx;
+} morse_data_t;
+
+void morse_data_init(morse_data_t *data, morse_data_cb_t callback, void *callback_ctx);
+
+// Switch from Morse to data mode; gives up after timeout_us without a preamble
+void morse_data_start(morse_data_t *data, int64_t time_us, int64_t timeout_us);
+
+// Feed edges and idle ticks while active. Both return false once the receiver
+// is back in Morse mode; that edge or tick then belongs to the Morse decoder.
+bool morse_data_edge(morse_data_t *data, bool rising, int64_t time_us);
+bool morse_data_tick(morse_data_t *data, int64_t time_us);
+
+static inline bool morse_data_active(const morse_data_t *data)
+{
+    return data->state != MORSE_DATA_IDLE;
+}
@@ -0,0 +1,78 @@
+/*
+ * Author: Noah Laforet
+ * Morse decoder state machine
+ *
+ * Platform-independent core shared by every receiver build: it consumes light
+ * edges and clock ticks, classifies pulses and gaps, walks the lookup tree and
+ * reports what it finds through a single event callback. It has no ESP-IDF
+ * dependencies; sampling, logging and output live in the front end.
+ *
+ * Decoded text is not buffered here: every character (including the space
+ * at a word gap) is reported as soon as it resolves, so memory use does not
+ * depend on message length.
+ *
+ * All times are microseconds on the front end's clock.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "morse_profile.h"
+#include "morse_speed.h"
+
+#define MORSE_PATTERN_MAX       8       // Longest dot/dash string (plus terminator) for logging
+
+typedef enum {
+    MORSE_EVENT_DOT,            // duration_us = pulse length
+    MORSE_EVENT_DASH,           // duration_us = pulse length
+    MORSE_EVENT_LETTER_GAP,     // duration_us = gap length
+    MORSE_EVENT_WORD_GAP,       // duration_us = gap length
+    MORSE_EVENT_CHAR,           // ch = decoded character ('?' if unknown, ' ' at a word gap), index = tree index (0 for spaces)
+    MORSE_EVENT_MESSAGE,        // End of message after an idle period, length = characters in it
+} morse_event_type_t;
+
+typedef struct {
+    morse_event_type_t type;
+    int64_t time_us;
+    int64_t duration_us;
+    char ch;
+    uint8_t index;
+    uint32_t length;
+} morse_event_t;
+
+typedef void (*morse_event_cb_t)(const morse_event_t *event, void *ctx);
+
+// Per-channel state, ordered widest first so it packs without padding. The
+// letter being keyed is just its tree index: one byte, no symbol buffer.
+typedef struct {
+    int64_t edge_time;                  // Last rise (pulse start) or fall (gap start); edges alternate
+    int64_t last_activity_time;         // Last edge, or the last letter resolved by a timeout
+    int64_t last_print_time;            // Time the last message was emitted
+    morse_event_cb_t callback;
+    void *callback_ctx;
+    morse_speed_t speed;                // Dot-unit estimate and thresholds
+    uint32_t output_length;             // Characters reported since the last message
+    uint8_t morse_index;                // Position in the lookup tree (0 = empty letter)
+    uint8_t table;                      // Code table letters resolve in (0 = ITU)
+    bool light_state;
+} morse_decoder_t;
+
+void morse_decoder_init(morse_decoder_t *decoder, const morse_profile_t *profile, int64_t start_time_us,
+                        morse_event_cb_t callback, void *callback_ctx);
+
+// Light turned ON / OFF at time_us
+void morse_decoder_rise(morse_decoder_t *decoder, int64_t time_us);
+void morse_decoder_fall(morse_decoder_t *decoder, int64_t time_us);
+
+// No edge; advances the clock so idle timeouts can fire
+void morse_decoder_tick(morse_decoder_t *decoder, int64_t time_us);
+
+// Code table for the letters still to resolve (the one being keyed included).
+// Returns false and keeps the current table if `table` doesn't exist.
+bool morse_decoder_set_table(morse_decoder_t *decoder, uint8_t table);
+
+// Lookup helpers
+char morse_decode_index(uint8_t table, uint8_t index);
+const char *morse_table_name(uint8_t table);    // NULL if there is no such table
+const char *morse_index_pattern(uint8_t index, char pattern[MORSE_PATTERN_MAX]);
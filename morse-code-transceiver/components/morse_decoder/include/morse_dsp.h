@@ -0,0 +1,47 @@
+/*
+ * Author: Noah Laforet
+ * Matched filter for the photodiode signal
+ *
+ * A Morse element is a rectangular light pulse, so the matched filter is a
+ * boxcar: a moving average over a window of samples. Averaging N samples cuts
+ * white noise by sqrt(N), so the slicer can use a narrower hysteresis band and
+ * still reject noise once dots are only a few photodiode rise times long.
+ *
+ * Integer running sum, one add, one subtract and a shift per sample. Every
+ * edge is delayed by the same (N - 1) / 2 samples, which the front end
+ * subtracts from its timestamps.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define MORSE_DSP_MAX_TAPS      64      // Power of two
+
+typedef struct {
+    uint16_t history[MORSE_DSP_MAX_TAPS];
+    uint32_t sum;
+    uint32_t position;
+    uint32_t taps;                      // Power of two <= MORSE_DSP_MAX_TAPS
+    uint32_t shift;                     // log2(taps)
+} morse_dsp_t;
+
+// Window of at most `samples` (rounded down to a power of two), primed with `initial`
+void morse_dsp_init(morse_dsp_t *dsp, uint32_t samples, int32_t initial);
+
+// Taps morse_dsp_init() gives a window of at most `samples`
+uint32_t morse_dsp_taps(uint32_t samples);
+
+static inline int32_t morse_dsp_filter(morse_dsp_t *dsp, int32_t raw)
+{
+    uint32_t slot = dsp->position++ & (dsp->taps - 1);
+    dsp->sum += (uint32_t)raw - dsp->history[slot];
+    dsp->history[slot] = (uint16_t)raw;
+    return (int32_t)(dsp->sum >> dsp->shift);
+}
+
+// Group delay in samples
+static inline uint32_t morse_dsp_delay(const morse_dsp_t *dsp)
+{
+    return (dsp->taps - 1) / 2;
+}
@@ -0,0 +1,34 @@
+/*
+ * Author: Noah Laforet
+ * Forward error correction for framed mode: Reed-Solomon RS(15,11) over GF(16)
+ *
+ * Frames with type bit 0 set carry their payload as RS-coded hex digits (4-bit symbols):
+ * 11 data nibbles plus 4 parity nibbles per block, the last block shortened.
+ * Each block can repair 2 wrong digits, or up to 4 digits that came out as
+ * '?' or non-hex (erasures, whose positions are known), or 1 error plus 2
+ * erasures. The encoder is transmitter/src/morse_fec.py.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MORSE_RS_N              15
+#define MORSE_RS_K              11
+#define MORSE_RS_PARITY         (MORSE_RS_N - MORSE_RS_K)
+
+#define MORSE_FRAME_TYPE_FEC    1       // Frame type bit (see morse_frame.h)
+
+// Correct one block of nibbles (data first, parity last) in place.
+// erasures: bit i set = block[i] is unknown. Returns symbols corrected, every
+// erased one included (even where it turned out to be 0), or -1.
+int morse_rs_decode_block(uint8_t *block, size_t length, uint16_t erasures);
+
+// Correct a coded hex payload in place, block by block. Returns the number of
+// symbols corrected over all blocks, or -1 if any block is uncorrectable.
+int morse_fec_correct(char *hex, size_t length);
+
+// Extract the ASCII text from a corrected payload. `text` may alias `hex`.
+// Returns the text length, or -1 if the payload length is not a valid encoding.
+int morse_fec_unpack(const char *hex, size_t length, char *text);
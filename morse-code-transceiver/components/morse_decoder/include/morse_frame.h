@@ -0,0 +1,89 @@
+/*
+ * Author: Noah Laforet
+ * Framed mode: error-checked frames on top of decoded Morse characters
+ *
+ * A frame is an ordinary string of Morse characters between two prosigns:
+ *
+ *   EEEE <KA> T SS LL payload CCCC <AR>
+ *
+ *   EEEE       preamble: dots and letter gaps so the speed estimate locks
+ *              before the frame starts (ignored by the parser)
+ *   <KA>       -.-.-  start of frame (decoded as MORSE_FRAME_STX)
+ *   T          frame type, 1 hex digit: bit 0 set = RS-coded payload (see
+ *              morse_fec.h), bits 1-3 = code table the payload is keyed in
+ *              (0 = ITU; see transmitter/src/morse_code.py)
+ *   SS         sequence number, 2 hex digits
+ *   LL         payload length in characters, 2 hex digits
+ *   payload    LL characters, spaces included
+ *   CCCC       CRC-16/CCITT-FALSE over "T SS LL payload" as ASCII (for
+ *              RS-coded payloads, the coded payload after correction)
+ *   <AR>       .-.-.  end of frame (decoded as MORSE_FRAME_ETX)
+ *
+ * Everything but the payload is keyed in ITU Morse. The parser tells the
+ * front end which table the next character is in (morse_frame_table()), so
+ * the decoder can switch right after LL and back after the payload.
+ *
+ * The encoder is transmitter/src/morse_frame.py. The parser is fed the
+ * decoder's characters one at a time, prosigns included.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MORSE_FRAME_STX             '\x02'  // <KA> prosign
+#define MORSE_FRAME_ETX             '\x03'  // <AR> prosign
+#define MORSE_FRAME_HEADER_LEN      5       // T SS LL
+#define MORSE_FRAME_CRC_LEN         4       // CCCC
+#define MORSE_FRAME_PAYLOAD_MAX     255
+#define MORSE_FRAME_BODY_MAX        (MORSE_FRAME_HEADER_LEN + MORSE_FRAME_PAYLOAD_MAX + MORSE_FRAME_CRC_LEN)
+#define MORSE_FRAME_TABLE_SHIFT     1       // Type bits above the FEC flag hold the code table
+
+typedef enum {
+    MORSE_FRAME_OK,
+    MORSE_FRAME_BAD_CRC,
+    MORSE_FRAME_BAD_HEADER,     // Header is not hex
+    MORSE_FRAME_BAD_LENGTH,     // Payload length doesn't match LL, or frame too long
+    MORSE_FRAME_TRUNCATED,      // New <KA> or end of message before <AR>
+    MORSE_FRAME_UNCORRECTABLE,  // RS-coded: more symbol errors than RS can repair
+} morse_frame_status_t;
+
+typedef struct {
+    morse_frame_status_t status;
+    uint8_t type;
+    uint8_t table;              // Code table of the payload
+    uint8_t seq;
+    uint8_t length;             // Payload characters (decoded text if RS-coded)
+    uint8_t corrected;          // RS-coded: hex digits repaired
+    bool duplicate;             // Same sequence number as the last good frame (a repetition)
+    const char *payload;        // NUL-terminated, valid during the callback only (OK frames)
+} morse_frame_t;
+
+typedef void (*morse_frame_cb_t)(const morse_frame_t *frame, void *ctx);
+
+typedef struct {
+    bool active;                // Between <KA> and <AR>
+    uint16_t count;
+    char body[MORSE_FRAME_BODY_MAX + 1];
+    int last_seq;               // -1 until the first good frame
+    uint32_t frames_ok;
+    uint32_t frames_bad;
+    uint32_t symbols_corrected; // Total over all good RS-coded frames
+    morse_frame_cb_t callback;
+    void *callback_ctx;
+} morse_frame_parser_t;
+
+void morse_frame_init(morse_frame_parser_t *parser, morse_frame_cb_t callback, void *callback_ctx);
+
+// Feed every decoded character; characters outside a frame are ignored
+void morse_frame_put(morse_frame_parser_t *parser, char c);
+
+// End of message: an open frame is reported as truncated
+void morse_frame_end(morse_frame_parser_t *parser);
+
+// Code table the next character is expected in
+uint8_t morse_frame_table(const morse_frame_parser_t *parser);
+
+uint16_t morse_crc16(const char *data, size_t length);
@@ -0,0 +1,64 @@
+/*
+ * Author: Noah Laforet
+ * Lane reassembly: striped frames from several photodiodes back in order
+ *
+ * morse_transmitter_fast.py --pins drives several LEDs in lockstep and
+ * stripes a message's frames across them: frame k of a stripe carries
+ * sequence number first + k and goes out on lane k mod N. Each receiver
+ * channel parses its own frames (morse_frame.h); the sequence number is the
+ * lane tag, so the payloads can be put back in order whichever photodiode
+ * saw them and however the lanes are wired to the channels.
+ *
+ * Frames are held in a small window until the gap before them fills. Each
+ * lane delivers in order, so a missing frame is given up on once every
+ * channel that may still send has delivered a later one, or when the window
+ * is full. The stripe is over once every channel's message has ended: lanes
+ * end at different times, as their letters differ in length. A channel that
+ * stays dark (a message with fewer frames than lanes) never ends; its stripe
+ * closes when the next transmission starts on a lane that has. Sequence
+ * numbers may restart with each stripe.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "morse_frame.h"
+
+#define MORSE_LANES_WINDOW      8       // Frames held while waiting for a gap to fill
+#define MORSE_LANES_MAX         8       // Receiver channels (bits of the lane masks)
+
+// payload is NUL-terminated and only valid during the call; lost counts the
+// frames skipped just before this one
+typedef void (*morse_lanes_cb_t)(uint8_t seq, const char *payload, uint8_t length, uint8_t lost, void *ctx);
+
+typedef struct {
+    bool used;
+    uint8_t seq;
+    uint8_t length;
+    char payload[MORSE_FRAME_PAYLOAD_MAX + 1];
+} morse_lanes_slot_t;
+
+typedef struct {
+    morse_lanes_slot_t slots[MORSE_LANES_WINDOW];
+    uint8_t pending;            // Slots in use
+    uint8_t channels;           // Receiver channels; a new stripe waits for this many frames
+    bool synced;                // next_seq is known (first frame of the stripe placed)
+    uint8_t next_seq;
+    uint8_t active;             // Channels that delivered frames in this stripe
+    uint8_t last_seq[MORSE_LANES_MAX];  // Highest sequence number per active channel
+    uint8_t ended;              // Channels whose message ended since their last frame
+    uint32_t frames_ok;         // Delivered in order
+    uint32_t frames_lost;
+    morse_lanes_cb_t callback;
+    void *callback_ctx;
+} morse_lanes_t;
+
+void morse_lanes_init(morse_lanes_t *lanes, uint8_t channels, morse_lanes_cb_t callback, void *callback_ctx);
+
+// A frame parsed on one channel; anything but OK frames is ignored
+void morse_lanes_put(morse_lanes_t *lanes, uint8_t channel, const morse_frame_t *frame);
+
+// End of message on one channel: once every channel has ended, whatever is
+// held is delivered and the stripe is over
+void morse_lanes_end(morse_lanes_t *lanes, uint8_t channel);
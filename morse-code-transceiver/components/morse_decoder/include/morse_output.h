@@ -0,0 +1,32 @@
+/*
+ * Author: Noah Laforet
+ * Paged output buffer
+ *
+ * Collects streamed characters into fixed-size pages for sinks that want text
+ * in chunks (log lines, framed packets) rather than one character at a time.
+ * A page is handed to the callback when it fills or when the message ends, so
+ * memory use is one page regardless of message length.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MORSE_PAGE_SIZE         64      // Characters per page
+
+// data is NUL-terminated and only valid during the call
+typedef void (*morse_page_cb_t)(const char *data, size_t length, bool end_of_message, void *ctx);
+
+typedef struct {
+    char data[MORSE_PAGE_SIZE + 1];
+    size_t length;
+    morse_page_cb_t callback;
+    void *callback_ctx;
+} morse_page_t;
+
+void morse_page_init(morse_page_t *page, morse_page_cb_t callback, void *callback_ctx);
+void morse_page_put(morse_page_t *page, char c);
+
+// Hand over whatever is buffered (called at the end of a message)
+void morse_page_flush(morse_page_t *page, bool end_of_message);
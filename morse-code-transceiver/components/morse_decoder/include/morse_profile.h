@@ -0,0 +1,30 @@
+/*
+ * Author: Noah Laforet
+ * Morse decoder speed profiles
+ *
+ * A profile is the starting point for the decoder: the dot it expects, the
+ * shortest pulse it accepts and how fast the front end samples. With adaptive
+ * speed enabled the dot is only the initial estimate.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    MORSE_PROFILE_STANDARD,     // 200ms dots (morse_transmitter.py)
+    MORSE_PROFILE_FAST,         // 10ms dots, 10 chars/sec (morse_transmitter_fast.py)
+    MORSE_PROFILE_ULTRA_FAST,   // 2ms dots
+    MORSE_PROFILE_COUNT,
+} morse_profile_id_t;
+
+typedef struct {
+    const char *name;
+    int32_t dot_us;             // Nominal (or initial, when adaptive) dot duration
+    int32_t glitch_us;          // Pulses shorter than this are rejected as noise
+    uint32_t sample_freq_hz;    // Continuous ADC sample rate
+    bool adaptive;              // Track the sender's speed online
+} morse_profile_t;
+
+const morse_profile_t *morse_profile_get(morse_profile_id_t id);
@@ -0,0 +1,28 @@
+/*
+ * Author: Noah Laforet
+ * Morse receiver front end (ESP-IDF)
+ *
+ * Sets up the selected sampling front end (continuous ADC or GPIO edge
+ * capture), the sampler -> decoder edge queue and the FreeRTOS tasks, then
+ * returns. Decoder events are recorded by the decoder task and printed by a
+ * low-priority log task.
+ */
+
+#pragma once
+
+#include "morse_profile.h"
+
+// Profile chosen in menuconfig (Component config -> Morse Decoder)
+const morse_profile_t *morse_profile_default(void);
+
+// How much the log task prints (default from menuconfig)
+typedef enum {
+    MORSE_LOG_MESSAGES,     // Completed messages only
+    MORSE_LOG_CHARS,        // + every decoded character
+    MORSE_LOG_SYMBOLS,      // + every dot, dash and gap
+} morse_log_verbosity_t;
+
+void morse_rx_start(const morse_profile_t *profile);
+
+// Can be changed at any time, from any task
+void morse_rx_set_log_verbosity(morse_log_verbosity_t verbosity);
@@ -0,0 +1,63 @@
+/*
+ * Author: Noah Laforet
+ * Adaptive light slicer
+ *
+ * Turns raw photodiode samples into ON/OFF decisions. The OFF and ON levels
+ * are tracked as slow EWMA envelopes, the decision threshold sits halfway
+ * between them with a hysteresis band, and a state change is only accepted
+ * after a run of consecutive samples past the threshold, so noise spikes and
+ * ringing on the edges don't insert extra dots.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    bool adaptive;              // false: fixed threshold, no envelope tracking
+    int32_t low_q4;             // OFF level envelope (raw counts * 16)
+    int32_t high_q4;            // ON level envelope (raw counts * 16)
+    int32_t min_swing_q4;       // Smallest ON-OFF separation assumed
+    int32_t noise_q4;           // Peak noise measured during calibration
+    int32_t on_threshold;       // Raw value a sample must exceed to turn ON
+    int32_t off_threshold;      // Raw value a sample must drop below to turn OFF
+    bool state;                 // Current ON/OFF decision
+    uint32_t pending;           // Consecutive samples disagreeing with state
+    uint32_t glitch_samples;    // Samples needed to accept a state change
+    uint32_t run_samples;       // Samples spent in the current state
+    uint32_t max_on_samples;    // ON longer than this is ambient light, not the LED
+    uint32_t rejected_glitches; // Runs too short to count as an edge
+} morse_slicer_t;
+
+// Calibration statistics gathered while the LED is off
+typedef struct {
+    int64_t sum;
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+} morse_slicer_cal_t;
+
+void morse_slicer_cal_reset(morse_slicer_cal_t *cal);
+void morse_slicer_cal_add(morse_slicer_cal_t *cal, int32_t raw);
+
+// Adaptive slicer seeded from calibration (LED off)
+void morse_slicer_init(morse_slicer_t *slicer, const morse_slicer_cal_t *cal, int32_t min_swing,
+                       uint32_t glitch_samples, uint32_t max_on_samples);
+
+// Fixed threshold with glitch rejection only
+void morse_slicer_init_fixed(morse_slicer_t *slicer, int32_t threshold, uint32_t glitch_samples);
+
+// Feed one sample. Returns true when the state changed; the change happened
+// `*edge_delay` samples ago (the start of the run that confirmed it).
+bool morse_slicer_feed(morse_slicer_t *slicer, int32_t raw, uint32_t *edge_delay);
+
+static inline int32_t morse_slicer_low(const morse_slicer_t *slicer)
+{
+    return slicer->low_q4 / 16;
+}
+
+static inline int32_t morse_slicer_high(const morse_slicer_t *slicer)
+{
+    return slicer->high_q4 / 16;
+}
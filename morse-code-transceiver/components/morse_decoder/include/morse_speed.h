@@ -0,0 +1,63 @@
+/*
+ * Author: Noah Laforet
+ * Adaptive Morse speed tracking
+ *
+ * Estimates the dot unit online from measured pulse and gap durations and
+ * derives the dot/dash and letter/word classification thresholds from it, so
+ * one receiver follows whatever speed the transmitter is using. All durations
+ * are integer microseconds, so sub-millisecond dots keep their resolution.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MORSE_SPEED_MIN_DOT_US      100     // Fastest dot the estimator will follow
+#define MORSE_SPEED_MAX_DOT_US      1000000 // Slowest dot the estimator will follow
+#define MORSE_SPEED_MAX_PULSE_US    (3 * MORSE_SPEED_MAX_DOT_US)    // Longer pulses are not Morse
+
+typedef enum {
+    MORSE_PULSE_GLITCH,     // Too short (or far too long) to be a symbol
+    MORSE_PULSE_DOT,
+    MORSE_PULSE_DASH,
+} morse_pulse_t;
+
+typedef enum {
+    MORSE_GAP_SYMBOL,       // Between dots/dashes of one letter (1 unit)
+    MORSE_GAP_LETTER,       // Between letters (3 units)
+    MORSE_GAP_WORD,         // Between words (7 units)
+} morse_gap_t;
+
+typedef struct {
+    int32_t dot_us;         // Estimated dot unit
+    int32_t glitch_us;      // Pulses shorter than this are noise, not dots
+    int32_t dash_q8;        // Dot/dash threshold in units * 256
+    int32_t letter_q8;      // Symbol/letter gap threshold in units * 256
+    int32_t word_q8;        // Letter/word gap threshold in units * 256
+    int32_t tolerance_q8;   // Tolerance model: relative timing error * 256 (0 = fixed thresholds)
+    int32_t jitter_us;      // Tolerance model: absolute error of one edge
+    bool adaptive;          // false: keep the initial dot and fixed thresholds
+} morse_speed_t;
+
+void morse_speed_init(morse_speed_t *speed, int32_t initial_dot_us, int32_t glitch_us, bool adaptive);
+
+// Switch from midpoint to maximum-likelihood (geometric mean) thresholds
+void morse_speed_use_ml_thresholds(morse_speed_t *speed);
+
+// Derive the thresholds from a timing error model instead: every duration
+// is off by `tolerance_pct` percent of itself (sender clock, smear) plus
+// `jitter_us` at each of its two edges (sampling, slicer). Thresholds follow
+// the dot estimate; a tolerance of 0 restores the midpoint thresholds.
+void morse_speed_set_tolerance(morse_speed_t *speed, int32_t tolerance_pct, int32_t jitter_us);
+
+// Classify a pulse and fold it into the dot estimate
+morse_pulse_t morse_speed_classify_pulse(morse_speed_t *speed, int64_t duration_us);
+
+// Classify a gap and fold symbol/letter gaps into the dot estimate
+morse_gap_t morse_speed_classify_gap(morse_speed_t *speed, int64_t duration_us);
+
+int32_t morse_speed_dot_us(const morse_speed_t *speed);
+int32_t morse_speed_letter_gap_us(const morse_speed_t *speed);
+int32_t morse_speed_word_gap_us(const morse_speed_t *speed);
+int32_t morse_speed_wpm(const morse_speed_t *speed);
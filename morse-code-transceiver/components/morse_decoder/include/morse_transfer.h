@@ -0,0 +1,56 @@
+/*
+ * Author: Noah Laforet
+ * File transfer accounting
+ *
+ * morse_transfer.py sends a file as numbered chunks in ordinary frames,
+ * resending only the frames the receiver's @link reports say were lost.
+ * Their payloads are:
+ *
+ *   FILE CCCC BBBBBBBB   start: chunk count and file size (hex, no spaces)
+ *   FD NNNN base32       chunk N (hex) of the file, base32 without padding
+ *   FEND                 end of the transfer
+ *
+ * The receiver has nowhere to keep the file. This tracks which chunks have
+ * arrived, so repeats are told apart from new chunks (only new ones are
+ * passed on, see morse_rx.c), and measures the goodput: distinct file bytes
+ * per second from the start frame to the last new chunk, on the receive
+ * times the caller gives with each frame payload.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MORSE_TRANSFER_MAX_CHUNKS   4096    // Chunks a transfer may have (one bit each)
+
+typedef enum {
+    MORSE_TRANSFER_NONE,        // Not a transfer frame (or no transfer running)
+    MORSE_TRANSFER_STARTED,
+    MORSE_TRANSFER_CHUNK,       // A chunk not seen before
+    MORSE_TRANSFER_REPEAT,      // A chunk already received
+    MORSE_TRANSFER_DONE,        // The last missing chunk
+    MORSE_TRANSFER_ENDED,       // FEND before every chunk arrived
+} morse_transfer_result_t;
+
+typedef struct {
+    bool active;
+    uint16_t chunks;            // Announced by the start frame
+    uint16_t received;          // Distinct chunks so far
+    uint32_t bytes;             // Announced file size
+    uint32_t bytes_received;    // Distinct file bytes so far
+    uint32_t frames;            // Chunk frames, repeats included
+    int64_t start_us;
+    int64_t last_us;            // Last new chunk
+    uint8_t seen[MORSE_TRANSFER_MAX_CHUNKS / 8];
+} morse_transfer_t;
+
+void morse_transfer_init(morse_transfer_t *transfer);
+
+// A good frame's payload; anything that isn't a transfer frame is ignored
+morse_transfer_result_t morse_transfer_put(morse_transfer_t *transfer, const char *payload, size_t length,
+                                           int64_t time_us);
+
+// Distinct file bytes per second so far
+uint32_t morse_transfer_goodput(const morse_transfer_t *transfer);
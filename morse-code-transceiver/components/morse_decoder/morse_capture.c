@@ -0,0 +1,112 @@
+/*
+ * Author: Noah Laforet
+ * Raw ADC capture blocks
+ */
+
+#include <string.h>
+#include "morse_capture.h"
+#include "morse_frame.h"
+
+#define SYNC0           'M'
+#define SYNC1           'C'
+
+static void put16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *out, uint32_t value)
+{
+    put16(out, (uint16_t)value);
+    put16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get16(const uint8_t *in)
+{
+    return (uint16_t)(in[0] | in[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *in)
+{
+    return get16(in) | (uint32_t)get16(in + 2) << 16;
+}
+
+void morse_capture_init(morse_capture_t *capture, uint8_t channel, uint32_t sample_freq_hz, uint16_t decimation)
+{
+    memset(capture, 0, sizeof(*capture));
+    capture->block.channel = channel;
+    capture->block.decimation = decimation ? decimation : 1;
+    capture->block.sample_freq_hz = sample_freq_hz / capture->block.decimation;
+}
+
+size_t morse_capture_pack(morse_capture_t *capture, uint8_t *out)
+{
+    morse_capture_block_t *block = &capture->block;
+    out[0] = SYNC0;
+    out[1] = SYNC1;
+    out[2] = MORSE_CAPTURE_VERSION;
+    out[3] = block->channel;
+    put16(out + 4, block->count);
+    put16(out + 6, block->decimation);
+    put32(out + 8, block->sample_freq_hz);
+    put32(out + 12, capture->next_sample);
+    put16(out + 16, block->dropped);
+
+    uint8_t *p = out + MORSE_CAPTURE_HEADER_BYTES;
+    for (uint16_t i = 0; i < block->count; i += 2) {
+        uint16_t a = block->samples[i] & MORSE_CAPTURE_SAMPLE_MAX;
+        uint16_t b = block->samples[i + 1] & MORSE_CAPTURE_SAMPLE_MAX;
+        *p++ = (uint8_t)a;
+        *p++ = (uint8_t)(a >> 8 | b << 4);
+        *p++ = (uint8_t)(b >> 4);
+    }
+
+    capture->next_sample += block->count;
+    capture->unsent_dropped = block->dropped;
+    block->dropped = 0;
+    block->count = 0;
+    return (size_t)(p - out);
+}
+
+void morse_capture_drop(morse_capture_t *capture)
+{
+    uint32_t dropped = (uint32_t)capture->block.dropped + capture->unsent_dropped + 1;
+    capture->block.dropped = dropped > UINT16_MAX ? UINT16_MAX : (uint16_t)dropped;
+}
+
+size_t morse_capture_seal(uint8_t *block, size_t length)
+{
+    put16(block + length, morse_crc16((const char *)block, length));
+    return length + MORSE_CAPTURE_CRC_BYTES;
+}
+
+size_t morse_capture_unpack(const uint8_t *data, size_t available, morse_capture_block_t *block)
+{
+    if (available < MORSE_CAPTURE_HEADER_BYTES + MORSE_CAPTURE_CRC_BYTES ||
+        data[0] != SYNC0 || data[1] != SYNC1 || data[2] != MORSE_CAPTURE_VERSION) {
+        return 0;
+    }
+    uint16_t count = get16(data + 4);
+    if (count > MORSE_CAPTURE_BLOCK_SAMPLES || count % 2 != 0) {
+        return 0;
+    }
+    size_t length = MORSE_CAPTURE_HEADER_BYTES + (size_t)count * 3 / 2;
+    if (available < length + MORSE_CAPTURE_CRC_BYTES ||
+        get16(data + length) != morse_crc16((const char *)data, length)) {
+        return 0;
+    }
+
+    block->channel = data[3];
+    block->count = count;
+    block->decimation = get16(data + 6);
+    block->sample_freq_hz = get32(data + 8);
+    block->first_sample = get32(data + 12);
+    block->dropped = get16(data + 16);
+    const uint8_t *p = data + MORSE_CAPTURE_HEADER_BYTES;
+    for (uint16_t i = 0; i < count; i += 2, p += 3) {
+        block->samples[i] = (uint16_t)(p[0] | (p[1] & 0x0F) << 8);
+        block->samples[i + 1] = (uint16_t)(p[1] >> 4 | p[2] << 4);
+    }
+    return length + MORSE_CAPTURE_CRC_BYTES;
+}
@@ -0,0 +1,240 @@
+/*
+ * Author: Noah Laforet
+ * Data mode bit slicer with clock recovery
+ *
+ * Works on edges, not samples. After training, the slicer keeps the time of
+ * the last mid-bit edge. The next edge either comes one half bit later (a
+ * boundary between two equal bits, always followed by the next mid-bit edge)
+ * or a full bit later (the next mid-bit edge directly). The direction of
+ * each mid-bit edge is the bit: falling = 0, rising = 1. Every mid-bit edge
+ * also nudges the half-bit estimate, so slow clock drift between the Pi and
+ * the ESP32 is tracked across a whole 255-byte frame.
+ */
+
+#include <stddef.h>
+#include "morse_data.h"
+#include "morse_frame.h"
+
+#define CLOCK_SHIFT         4       // Half-bit estimate follows 1/16 of each bit's error
+#define LOST_CLOCK_HALVES   3       // No edge for this many half bits = end of signal
+#define TRAILER_HALVES      4       // Quiet time after the CRC before Morse resumes
+
+static void report(morse_data_t *data, morse_data_status_t status, int64_t time_us)
+{
+    uint8_t length = (data->count > 0) ? data->buffer[0] : 0;
+    morse_data_frame_t frame = {
+        .status = status,
+        .length = (status == MORSE_DATA_OK) ? length : 0,
+        .half_bit_us = data->half_bit_us,
+        .duration_us = time_us - data->first_edge_us,
+        .payload = &data->buffer[1],
+    };
+
+    if (status == MORSE_DATA_OK) {
+        data->frames_ok++;
+    } else {
+        data->frames_bad++;
+    }
+    if (data->callback) {
+        data->callback(&frame, data->callback_ctx);
+    }
+}
+
+static void fail(morse_data_t *data, morse_data_status_t status, int64_t time_us)
+{
+    report(data, status, time_us);
+    data->state = MORSE_DATA_IDLE;
+}
+
+static void start_training(morse_data_t *data, int64_t time_us)
+{
+    data->state = MORSE_DATA_TRAINING;
+    data->first_edge_us = time_us;
+    data->training_sum_us = 0;
+    data->training_count = 0;
+}
+
+static void finish_frame(morse_data_t *data, int64_t time_us)
+{
+    size_t covered = 1 + (size_t)data->buffer[0];
+    uint16_t crc = (uint16_t)((data->buffer[covered] << 8) | data->buffer[covered + 1]);
+
+    report(data, (crc == morse_crc16((const char *)data->buffer, covered)) ? MORSE_DATA_OK : MORSE_DATA_BAD_CRC, time_us);
+    data->state = MORSE_DATA_TRAILER;
+}
+
+static void put_bit(morse_data_t *data, int bit, int64_t time_us)
+{
+    data->shift = (uint16_t)((data->shift << 1) | bit);
+    data->bits++;
+
+    if (data->state == MORSE_DATA_HUNTING) {
+        if (data->shift == MORSE_DATA_SYNC_WORD) {
+            data->state = MORSE_DATA_RECEIVING;
+            data->bits = 0;
+            data->count = 0;
+        } else if (data->bits >= MORSE_DATA_HUNT_BITS) {
+            fail(data, MORSE_DATA_NO_SYNC, time_us);
+        }
+        return;
+    }
+
+    if ((data->bits & 7) != 0) {
+        return;
+    }
+    data->buffer[data->count++] = (uint8_t)data->shift;
+    if (data->count == 1 + data->buffer[0] + 2) {
+        finish_frame(data, time_us);
+    }
+}
+
+// One edge against the recovered clock; false if it doesn't fit
+static bool slice_edge(morse_data_t *data, bool rising, int64_t time_us)
+{
+    int64_t dt = time_us - data->last_mid_us;
+    int64_t half = data->half_bit_us;
+
+    if (2 * dt < half) {
+        return false;  // Glitch, or the clock is far off
+    }
+    if (2 * dt < 3 * half) {
+        if (data->boundary) {
+            return false;
+        }
+        data->boundary = true;  // Between two equal bits; the mid-bit edge follows
+        return true;
+    }
+    if (2 * dt >= 5 * half) {
+        return false;
+    }
+
+    data->half_bit_us += (int32_t)((dt - 2 * half) >> CLOCK_SHIFT);
+    data->last_mid_us = time_us;
+    data->boundary = false;
+    put_bit(data, rising ? 1 : 0, time_us);
+    return true;
+}
+
+static void train(morse_data_t *data, bool rising, int64_t time_us)
+{
+    int64_t interval = time_us - data->last_edge_us;
+
+    if (data->training_count > 0) {
+        int64_t average = data->training_sum_us / data->training_count;
+        if (2 * interval < average || 2 * interval > 3 * average) {
+            // Not the preamble (yet): start over on the next ON edge
+            data->state = MORSE_DATA_ARMED;
+            if (rising) {
+                start_training(data, time_us);
+            }
+            return;
+        }
+    }
+    data->training_sum_us += interval;
+    data->training_count++;
+
+    // The preamble is all zeros, so falling edges are mid-bit
+    if (data->training_count >= MORSE_DATA_TRAINING_EDGES && !rising) {
+        data->half_bit_us = (int32_t)(data->training_sum_us / data->training_count);
+        data->state = MORSE_DATA_HUNTING;
+        data->last_mid_us = time_us;
+        data->boundary = false;
+        data->shift = 0;
+        data->bits = 0;
+    }
+}
+
+void morse_data_init(morse_data_t *data, morse_data_cb_t callback, void *callback_ctx)
+{
+    *data = (morse_data_t){
+        .state = MORSE_DATA_IDLE,
+        .callback = callback,
+        .callback_ctx = callback_ctx,
+    };
+}
+
+void morse_data_start(morse_data_t *data, int64_t time_us, int64_t timeout_us)
+{
+    data->state = MORSE_DATA_ARMED;
+    data->armed_us = time_us;
+    data->timeout_us = timeout_us;
+    data->first_edge_us = time_us;
+    data->last_edge_us = time_us;
+    data->half_bit_us = 0;
+    data->count = 0;
+}
+
+bool morse_data_edge(morse_data_t *data, bool rising, int64_t time_us)
+{
+    if (data->state == MORSE_DATA_IDLE) {
+        return false;
+    }
+    if (data->state == MORSE_DATA_TRAILER && time_us - data->last_edge_us > TRAILER_HALVES * (int64_t)data->half_bit_us) {
+        data->state = MORSE_DATA_IDLE;  // Morse (or the next <SN>) started before a tick noticed the quiet
+        return false;
+    }
+
+    switch (data->state) {
+    case MORSE_DATA_ARMED:
+        if (rising) {  // The first preamble bit starts with the light ON
+            start_training(data, time_us);
+        }
+        break;
+    case MORSE_DATA_TRAINING:
+        train(data, rising, time_us);
+        break;
+    case MORSE_DATA_HUNTING:
+        if (!slice_edge(data, rising, time_us)) {
+            fail(data, MORSE_DATA_NO_SYNC, time_us);
+        }
+        break;
+    case MORSE_DATA_RECEIVING:
+        if (!slice_edge(data, rising, time_us)) {
+            fail(data, MORSE_DATA_LOST_CLOCK, time_us);
+        }
+        break;
+    default:
+        break;
+    }
+
+    data->last_edge_us = time_us;
+    return true;
+}
+
+bool morse_data_tick(morse_data_t *data, int64_t time_us)
+{
+    int64_t idle = time_us - data->last_edge_us;
+
+    switch (data->state) {
+    case MORSE_DATA_ARMED:
+        if (time_us - data->armed_us > data->timeout_us) {
+            fail(data, MORSE_DATA_NO_SYNC, time_us);
+        }
+        break;
+    case MORSE_DATA_TRAINING:
+        // Before the first interval there is no clock to compare against
+        if (data->training_count == 0 ? (time_us - data->armed_us > data->timeout_us)
+                                      : (idle * data->training_count > LOST_CLOCK_HALVES * data->training_sum_us)) {
+            fail(data, MORSE_DATA_NO_SYNC, time_us);
+        }
+        break;
+    case MORSE_DATA_HUNTING:
+        if (idle > LOST_CLOCK_HALVES * (int64_t)data->half_bit_us) {
+            fail(data, MORSE_DATA_NO_SYNC, time_us);
+        }
+        break;
+    case MORSE_DATA_RECEIVING:
+        if (idle > LOST_CLOCK_HALVES * (int64_t)data->half_bit_us) {
+            fail(data, MORSE_DATA_LOST_CLOCK, time_us);
+        }
+        break;
+    case MORSE_DATA_TRAILER:
+        if (idle > TRAILER_HALVES * (int64_t)data->half_bit_us) {
+            data->state = MORSE_DATA_IDLE;
+        }
+        break;
+    default:
+        break;
+    }
+    return morse_data_active(data);
+}
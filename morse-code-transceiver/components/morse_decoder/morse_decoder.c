@@ -0,0 +1,217 @@
+/*
+ * Author: Noah Laforet
+ * Morse decoder state machine
+ *
+ * 1. Rising edge: the gap that just ended is classified; a letter gap decodes
+ *    the current letter, a word gap also reports a space.
+ * 2. Falling edge: the pulse that just ended is classified as dot or dash and
+ *    moves the index down the lookup tree (dot -> 2i+1, dash -> 2i+2).
+ * 3. Every event: if the light has been off for a letter gap the pending
+ *    letter is decoded; after two word gaps the end of the message is reported.
+ */
+
+#include <stddef.h>
+#include "morse_decoder.h"
+#include "morse_table.h"        // Generated from transmitter/src/morse_code.py (all code tables)
+
+#define MORSE_INDEX_INVALID     0xFF    // Pattern ran past the deepest code in the tree
+
+_Static_assert(MORSE_TREE_SIZE < MORSE_INDEX_INVALID, "morse_trees must be indexable by a uint8_t");
+_Static_assert(MORSE_TREE_DEPTH < MORSE_PATTERN_MAX, "MORSE_PATTERN_MAX too small for the generated tree");
+// Every channel carries one of these; the small fields must share the last word
+_Static_assert(sizeof(morse_decoder_t) <= 3 * sizeof(int64_t) + 2 * sizeof(void *) + sizeof(morse_speed_t) + 8,
+               "morse_decoder_t grew or picked up padding");
+
+/*---------------------------------------------------------------
+        Lookup Tree
+---------------------------------------------------------------*/
+// Resolve a finished letter with a single table load
+char morse_decode_index(uint8_t table, uint8_t index)
+{
+    if (index == 0) {
+        return '\0';  // Empty pattern
+    }
+    if (index == MORSE_INDEX_INVALID || morse_trees[table][index] == '\0') {
+        return '?';  // Unknown pattern
+    }
+    return morse_trees[table][index];
+}
+
+const char *morse_table_name(uint8_t table)
+{
+    return (table < MORSE_TABLE_COUNT) ? morse_table_names[table] : NULL;
+}
+
+// Rebuild the dot/dash string for a tree index (log output only)
+const char *morse_index_pattern(uint8_t index, char pattern[MORSE_PATTERN_MAX])
+{
+    if (index == MORSE_INDEX_INVALID) {
+        return "(too long)";
+    }
+
+    int length = 0;
+    for (unsigned i = index; i > 0; i = (i - 1) / 2) {
+        length++;
+    }
+    pattern[length] = '\0';
+    for (unsigned i = index; i > 0; i = (i - 1) / 2) {
+        pattern[--length] = (i & 1) ? '.' : '-';
+    }
+    return pattern;
+}
+
+/*---------------------------------------------------------------
+        Helpers
+---------------------------------------------------------------*/
+static void emit(morse_decoder_t *decoder, morse_event_type_t type, int64_t time_us, int64_t duration_us)
+{
+    if (decoder->callback) {
+        morse_event_t event = {
+            .type = type,
+            .time_us = time_us,
+            .duration_us = duration_us,
+        };
+        decoder->callback(&event, decoder->callback_ctx);
+    }
+}
+
+static void emit_char(morse_decoder_t *decoder, int64_t time_us, char c, uint8_t index)
+{
+    decoder->output_length++;
+
+    if (decoder->callback) {
+        morse_event_t event = {
+            .type = MORSE_EVENT_CHAR,
+            .time_us = time_us,
+            .ch = c,
+            .index = index,
+        };
+        decoder->callback(&event, decoder->callback_ctx);
+    }
+}
+
+// Append a symbol to the current letter: dot -> 2i+1, dash -> 2i+2
+static void push_symbol(morse_decoder_t *decoder, bool dash)
+{
+    if (decoder->morse_index == MORSE_INDEX_INVALID) {
+        return;
+    }
+    unsigned next = 2u * decoder->morse_index + (dash ? 2u : 1u);
+    decoder->morse_index = (next < MORSE_TREE_SIZE) ? (uint8_t)next : MORSE_INDEX_INVALID;
+}
+
+static void process_letter(morse_decoder_t *decoder, int64_t time_us)
+{
+    if (decoder->morse_index == 0) {
+        return;
+    }
+
+    emit_char(decoder, time_us, morse_decode_index(decoder->table, decoder->morse_index), decoder->morse_index);
+
+    // Start the next letter at the root of the tree
+    decoder->morse_index = 0;
+}
+
+static void check_timeouts(morse_decoder_t *decoder, int64_t current_time)
+{
+    if (decoder->light_state) {
+        return;
+    }
+
+    // Timeout: if no activity for a letter gap and a letter is pending, decode it
+    int64_t idle_time = current_time - decoder->last_activity_time;
+    if (decoder->morse_index != 0 && idle_time > morse_speed_letter_gap_us(&decoder->speed)) {
+        process_letter(decoder, current_time);
+        decoder->last_activity_time = current_time;  // Reset after processing
+        idle_time = 0;
+    }
+
+    // Report the end of the message if idle for very long
+    int64_t end_of_message_us = morse_speed_word_gap_us(&decoder->speed) * 2;
+    if (idle_time > end_of_message_us &&
+        current_time - decoder->last_print_time > end_of_message_us &&
+        decoder->output_length > 0) {
+        if (decoder->callback) {
+            morse_event_t event = {
+                .type = MORSE_EVENT_MESSAGE,
+                .time_us = current_time,
+                .length = decoder->output_length,
+            };
+            decoder->callback(&event, decoder->callback_ctx);
+        }
+
+        decoder->output_length = 0;
+        decoder->last_print_time = current_time;
+    }
+}
+
+/*---------------------------------------------------------------
+        Public API
+---------------------------------------------------------------*/
+void morse_decoder_init(morse_decoder_t *decoder, const morse_profile_t *profile, int64_t start_time_us,
+                        morse_event_cb_t callback, void *callback_ctx)
+{
+    *decoder = (morse_decoder_t) {0};
+    morse_speed_init(&decoder->speed, profile->dot_us, profile->glitch_us, profile->adaptive);
+    decoder->edge_time = start_time_us;
+    decoder->last_activity_time = start_time_us;
+    decoder->callback = callback;
+    decoder->callback_ctx = callback_ctx;
+}
+
+bool morse_decoder_set_table(morse_decoder_t *decoder, uint8_t table)
+{
+    if (table >= MORSE_TABLE_COUNT) {
+        return false;
+    }
+    decoder->table = table;
+    return true;
+}
+
+void morse_decoder_rise(morse_decoder_t *decoder, int64_t time_us)
+{
+    int64_t gap_duration = time_us - decoder->edge_time;
+    decoder->light_state = true;
+
+    // Check if gap indicates end of letter or word
+    morse_gap_t gap = morse_speed_classify_gap(&decoder->speed, gap_duration);
+    // The letter the gap ends is reported first, then the gap
+    if (gap == MORSE_GAP_WORD) {
+        process_letter(decoder, time_us);
+        if (decoder->output_length > 0) {
+            emit_char(decoder, time_us, ' ', 0);  // No leading space on a new message
+        }
+        emit(decoder, MORSE_EVENT_WORD_GAP, time_us, gap_duration);
+    } else if (gap == MORSE_GAP_LETTER) {
+        process_letter(decoder, time_us);
+        emit(decoder, MORSE_EVENT_LETTER_GAP, time_us, gap_duration);
+    }
+
+    decoder->edge_time = time_us;
+    decoder->last_activity_time = time_us;
+}
+
+void morse_decoder_fall(morse_decoder_t *decoder, int64_t time_us)
+{
+    int64_t pulse_duration = time_us - decoder->edge_time;
+    decoder->light_state = false;
+
+    // Classify pulse as dot or dash relative to the current dot estimate
+    morse_pulse_t pulse = morse_speed_classify_pulse(&decoder->speed, pulse_duration);
+    if (pulse == MORSE_PULSE_DASH) {
+        push_symbol(decoder, true);
+        emit(decoder, MORSE_EVENT_DASH, time_us, pulse_duration);
+    } else if (pulse == MORSE_PULSE_DOT) {
+        push_symbol(decoder, false);
+        emit(decoder, MORSE_EVENT_DOT, time_us, pulse_duration);
+    }
+
+    decoder->edge_time = time_us;
+    decoder->last_activity_time = time_us;
+    check_timeouts(decoder, time_us);
+}
+
+void morse_decoder_tick(morse_decoder_t *decoder, int64_t time_us)
+{
+    check_timeouts(decoder, time_us);
+}
@@ -0,0 +1,30 @@
+/*
+ * Author: Noah Laforet
+ * Matched filter for the photodiode signal
+ */
+
+#include "morse_dsp.h"
+
+uint32_t morse_dsp_taps(uint32_t samples)
+{
+    uint32_t taps = 1;
+    while (taps * 2 <= samples && taps * 2 <= MORSE_DSP_MAX_TAPS) {
+        taps *= 2;
+    }
+    return taps;
+}
+
+void morse_dsp_init(morse_dsp_t *dsp, uint32_t samples, int32_t initial)
+{
+    dsp->taps = morse_dsp_taps(samples);
+    dsp->shift = 0;
+    while ((1u << dsp->shift) < dsp->taps) {
+        dsp->shift++;
+    }
+
+    for (uint32_t i = 0; i < dsp->taps; i++) {
+        dsp->history[i] = (uint16_t)initial;
+    }
+    dsp->sum = (uint32_t)initial * dsp->taps;
+    dsp->position = 0;
+}
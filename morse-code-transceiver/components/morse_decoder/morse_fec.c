@@ -0,0 +1,256 @@
+/*
+ * Author: Noah Laforet
+ * Reed-Solomon RS(15,11) over GF(16)
+ *
+ * GF(16) from x^4 + x + 1 (alpha = 2), roots alpha^1..alpha^4, symbol i of an
+ * L-symbol block is the coefficient of x^(L-1-i). The tables are const, so
+ * they live in flash.
+ *
+ * Fast path: four syndromes; all zero means the block is clean, which is what
+ * almost every block is. Slow path: with only 2t = 4 parity symbols there are
+ * at most C(15, 2) = 105 candidate error-location sets, so instead of
+ * Berlekamp-Massey the decoder tries each set (erasures always included, the
+ * fewest errors first) and solves the syndrome equations for the magnitudes
+ * by Gaussian elimination. The first set that satisfies all four syndromes is
+ * the correction. Worst case is a few thousand table lookups per bad block.
+ */
+
+#include <stdbool.h>
+#include "morse_fec.h"
+
+static const uint8_t gf_exp[30] = {
+    1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9, 1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9,
+};
+
+static const uint8_t gf_log[16] = {
+    0, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12,
+};
+
+static inline uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    return (a && b) ? gf_exp[gf_log[a] + gf_log[b]] : 0;
+}
+
+static inline uint8_t gf_div(uint8_t a, uint8_t b)
+{
+    return a ? gf_exp[gf_log[a] + 15 - gf_log[b]] : 0;
+}
+
+static inline uint8_t gf_pow_alpha(unsigned power)
+{
+    return gf_exp[power % 15];
+}
+
+static int nibble(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/*---------------------------------------------------------------
+        Block Decoder
+---------------------------------------------------------------*/
+// Solve sum_p Y_p * X_p^j = S_j (j = 1..4) for the given positions and apply
+// the magnitudes. `errors` marks positions that must change (non-erasures).
+static bool try_positions(uint8_t *block, size_t length, const uint8_t *syndromes,
+                          const uint8_t *positions, int count, uint16_t errors)
+{
+    uint8_t matrix[MORSE_RS_PARITY][MORSE_RS_PARITY + 1];
+    uint8_t x[MORSE_RS_PARITY];
+
+    for (int p = 0; p < count; p++) {
+        x[p] = gf_pow_alpha((unsigned)(length - 1 - positions[p]));
+    }
+    for (int j = 0; j < count; j++) {
+        for (int p = 0; p < count; p++) {
+            matrix[j][p] = gf_pow_alpha((unsigned)gf_log[x[p]] * (unsigned)(j + 1));
+        }
+        matrix[j][count] = syndromes[j];
+    }
+
+    // Gaussian elimination (X_p distinct and nonzero: always solvable)
+    for (int col = 0; col < count; col++) {
+        int pivot = col;
+        while (matrix[pivot][col] == 0) {
+            pivot++;
+        }
+        for (int k = 0; k <= count; k++) {
+            uint8_t t = matrix[col][k];
+            matrix[col][k] = matrix[pivot][k];
+            matrix[pivot][k] = t;
+        }
+        uint8_t inv = matrix[col][col];
+        for (int k = col; k <= count; k++) {
+            matrix[col][k] = gf_div(matrix[col][k], inv);
+        }
+        for (int row = 0; row < count; row++) {
+            uint8_t factor = matrix[row][col];
+            if (row != col && factor) {
+                for (int k = col; k <= count; k++) {
+                    matrix[row][k] ^= gf_mul(factor, matrix[col][k]);
+                }
+            }
+        }
+    }
+
+    uint8_t magnitude[MORSE_RS_PARITY] = {0};
+    for (int p = 0; p < count; p++) {
+        magnitude[p] = matrix[p][count];
+        if ((errors >> positions[p] & 1) && magnitude[p] == 0) {
+            return false;  // An error that isn't: a smaller set already covers it
+        }
+    }
+
+    // The remaining syndromes must agree too
+    for (int j = count; j < MORSE_RS_PARITY; j++) {
+        uint8_t sum = 0;
+        for (int p = 0; p < count; p++) {
+            sum ^= gf_mul(magnitude[p], gf_pow_alpha((unsigned)gf_log[x[p]] * (unsigned)(j + 1)));
+        }
+        if (sum != syndromes[j]) {
+            return false;
+        }
+    }
+
+    for (int p = 0; p < count; p++) {
+        block[positions[p]] ^= magnitude[p];
+    }
+    return true;
+}
+
+int morse_rs_decode_block(uint8_t *block, size_t length, uint16_t erasures)
+{
+    if (length <= MORSE_RS_PARITY || length > MORSE_RS_N) {
+        return -1;
+    }
+
+    uint8_t syndromes[MORSE_RS_PARITY];
+    bool clean = true;
+    for (int j = 0; j < MORSE_RS_PARITY; j++) {
+        // Horner: r(alpha^(j+1)), highest degree first
+        uint8_t root = gf_pow_alpha((unsigned)(j + 1));
+        uint8_t sum = 0;
+        for (size_t i = 0; i < length; i++) {
+            sum = gf_mul(sum, root) ^ block[i];
+        }
+        syndromes[j] = sum;
+        clean &= (sum == 0);
+    }
+    if (clean) {
+        // Erased digits that stood for 0 were still filled in
+        int erased = __builtin_popcount(erasures & ((1u << length) - 1));
+        return (erased <= MORSE_RS_PARITY) ? erased : -1;
+    }
+
+    uint8_t positions[MORSE_RS_PARITY];
+    int erased = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (erasures >> i & 1) {
+            if (erased == MORSE_RS_PARITY) {
+                return -1;
+            }
+            positions[erased++] = (uint8_t)i;
+        }
+    }
+
+    // Fewest unknown errors first: 2 * errors + erasures <= 4
+    for (int errors = 0; 2 * errors + erased <= MORSE_RS_PARITY; errors++) {
+        if (errors == 0) {
+            if (erased && try_positions(block, length, syndromes, positions, erased, 0)) {
+                return erased;
+            }
+            continue;
+        }
+        for (uint8_t a = 0; a < length; a++) {
+            if (erasures >> a & 1) {
+                continue;
+            }
+            positions[erased] = a;
+            if (errors == 1) {
+                if (try_positions(block, length, syndromes, positions, erased + 1, 1u << a)) {
+                    return erased + 1;
+                }
+                continue;
+            }
+            for (uint8_t b = a + 1; b < length; b++) {
+                if (erasures >> b & 1) {
+                    continue;
+                }
+                positions[erased + 1] = b;
+                if (try_positions(block, length, syndromes, positions, erased + 2, (1u << a) | (1u << b))) {
+                    return erased + 2;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/*---------------------------------------------------------------
+        Payloads
+---------------------------------------------------------------*/
+int morse_fec_correct(char *hex, size_t length)
+{
+    int corrected = 0;
+
+    for (size_t start = 0; start < length; start += MORSE_RS_N) {
+        size_t block_length = (length - start < MORSE_RS_N) ? length - start : MORSE_RS_N;
+        uint8_t block[MORSE_RS_N];
+        uint16_t erasures = 0;
+
+        for (size_t i = 0; i < block_length; i++) {
+            int value = nibble(hex[start + i]);
+            if (value < 0) {
+                erasures |= 1u << i;  // '?' or a letter that isn't hex
+                value = 0;
+            }
+            block[i] = (uint8_t)value;
+        }
+
+        int fixed = morse_rs_decode_block(block, block_length, erasures);
+        if (fixed < 0) {
+            return -1;
+        }
+        if (fixed > 0 || erasures) {
+            for (size_t i = 0; i < block_length; i++) {
+                hex[start + i] = hex_digits[block[i]];
+            }
+            corrected += fixed;
+        }
+    }
+    return corrected;
+}
+
+int morse_fec_unpack(const char *hex, size_t length, char *text)
+{
+    int text_length = 0;
+    int high = -1;
+
+    for (size_t start = 0; start < length; start += MORSE_RS_N) {
+        size_t block_length = (length - start < MORSE_RS_N) ? length - start : MORSE_RS_N;
+        if (block_length <= MORSE_RS_PARITY) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < block_length - MORSE_RS_PARITY; i++) {
+            int value = nibble(hex[start + i]);
+            if (value < 0) {
+                return -1;
+            }
+            if (high < 0) {
+                high = value;
+            } else {
+                text[text_length++] = (char)((high << 4) | value);
+                high = -1;
+            }
+        }
+    }
+    return (high < 0) ? text_length : -1;
+}
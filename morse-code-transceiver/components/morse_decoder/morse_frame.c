@@ -0,0 +1,189 @@
+/*
+ * Author: Noah Laforet
+ * Framed mode parser
+ *
+ * Collects the characters between <KA> and <AR>, then checks the header, the
+ * length and the CRC and reports the frame once, pass or fail. RS-coded
+ * payloads are RS-corrected in place before the CRC check, so the CRC also
+ * catches a miscorrection.
+ */
+
+#include "morse_frame.h"
+#include "morse_fec.h"
+
+uint16_t morse_crc16(const char *data, size_t length)
+{
+    // CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, no reflection
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)((uint8_t)data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Parse `digits` hex characters; -1 if any is not hex
+static int32_t parse_hex(const char *text, int digits)
+{
+    int32_t value = 0;
+    for (int i = 0; i < digits; i++) {
+        int nibble = hex_value(text[i]);
+        if (nibble < 0) {
+            return -1;
+        }
+        value = (value << 4) | nibble;
+    }
+    return value;
+}
+
+static void report(morse_frame_parser_t *parser, morse_frame_t *frame)
+{
+    if (frame->status == MORSE_FRAME_OK) {
+        frame->duplicate = (frame->seq == parser->last_seq);
+        parser->last_seq = frame->seq;
+        parser->frames_ok++;
+    } else {
+        parser->frames_bad++;
+    }
+
+    if (parser->callback) {
+        parser->callback(frame, parser->callback_ctx);
+    }
+    parser->active = false;
+}
+
+static void finish_frame(morse_frame_parser_t *parser)
+{
+    morse_frame_t frame = { .status = MORSE_FRAME_BAD_LENGTH };
+    const char *body = parser->body;
+
+    if (parser->count < MORSE_FRAME_HEADER_LEN + MORSE_FRAME_CRC_LEN) {
+        report(parser, &frame);
+        return;
+    }
+
+    int32_t type = parse_hex(&body[0], 1);
+    int32_t seq = parse_hex(&body[1], 2);
+    int32_t length = parse_hex(&body[3], 2);
+    if (type < 0 || seq < 0 || length < 0) {
+        frame.status = MORSE_FRAME_BAD_HEADER;
+        report(parser, &frame);
+        return;
+    }
+    frame.type = (uint8_t)type;
+    frame.table = (uint8_t)(type >> MORSE_FRAME_TABLE_SHIFT);
+    frame.seq = (uint8_t)seq;
+    frame.length = (uint8_t)length;
+
+    if (parser->count != MORSE_FRAME_HEADER_LEN + length + MORSE_FRAME_CRC_LEN) {
+        report(parser, &frame);
+        return;
+    }
+
+    char *payload = &parser->body[MORSE_FRAME_HEADER_LEN];
+    int corrected = 0;
+    if (type & MORSE_FRAME_TYPE_FEC) {
+        corrected = morse_fec_correct(payload, (size_t)length);
+        if (corrected < 0) {
+            frame.status = MORSE_FRAME_UNCORRECTABLE;
+            report(parser, &frame);
+            return;
+        }
+    }
+
+    size_t covered = MORSE_FRAME_HEADER_LEN + (size_t)length;
+    int32_t crc = parse_hex(&body[covered], MORSE_FRAME_CRC_LEN);
+    if (crc < 0 || (uint16_t)crc != morse_crc16(body, covered)) {
+        frame.status = MORSE_FRAME_BAD_CRC;
+        report(parser, &frame);
+        return;
+    }
+
+    if (type & MORSE_FRAME_TYPE_FEC) {
+        int text_length = morse_fec_unpack(payload, (size_t)length, payload);
+        if (text_length < 0) {
+            frame.status = MORSE_FRAME_BAD_LENGTH;
+            report(parser, &frame);
+            return;
+        }
+        frame.length = (uint8_t)text_length;
+        frame.corrected = (uint8_t)corrected;
+        parser->symbols_corrected += (uint32_t)corrected;
+    }
+
+    payload[frame.length] = '\0';
+    frame.status = MORSE_FRAME_OK;
+    frame.payload = payload;
+    report(parser, &frame);
+}
+
+void morse_frame_init(morse_frame_parser_t *parser, morse_frame_cb_t callback, void *callback_ctx)
+{
+    parser->active = false;
+    parser->count = 0;
+    parser->last_seq = -1;
+    parser->frames_ok = 0;
+    parser->frames_bad = 0;
+    parser->symbols_corrected = 0;
+    parser->callback = callback;
+    parser->callback_ctx = callback_ctx;
+}
+
+void morse_frame_put(morse_frame_parser_t *parser, char c)
+{
+    if (c == MORSE_FRAME_STX) {
+        morse_frame_end(parser);  // A frame still open lost its <AR>
+        parser->active = true;
+        parser->count = 0;
+        return;
+    }
+    if (!parser->active) {
+        return;
+    }
+    if (c == MORSE_FRAME_ETX) {
+        finish_frame(parser);
+        return;
+    }
+
+    if (parser->count == MORSE_FRAME_BODY_MAX) {
+        morse_frame_t frame = { .status = MORSE_FRAME_BAD_LENGTH };
+        report(parser, &frame);
+        return;
+    }
+    parser->body[parser->count++] = c;
+}
+
+void morse_frame_end(morse_frame_parser_t *parser)
+{
+    if (parser->active) {
+        morse_frame_t frame = { .status = MORSE_FRAME_TRUNCATED };
+        report(parser, &frame);
+    }
+}
+
+uint8_t morse_frame_table(const morse_frame_parser_t *parser)
+{
+    if (!parser->active || parser->count < MORSE_FRAME_HEADER_LEN) {
+        return 0;
+    }
+
+    int32_t type = parse_hex(&parser->body[0], 1);
+    int32_t length = parse_hex(&parser->body[3], 2);
+    if (type < 0 || length < 0 || parser->count >= MORSE_FRAME_HEADER_LEN + length) {
+        return 0;  // Bad header (the frame will fail anyway), or on to the CRC
+    }
+    return (uint8_t)(type >> MORSE_FRAME_TABLE_SHIFT);
+}
@@ -0,0 +1,170 @@
+/*
+ * Author: Noah Laforet
+ * Lane reassembly
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "morse_lanes.h"
+
+// Signed distance of seq from base, modulo 256
+static int seq_distance(uint8_t seq, uint8_t base)
+{
+    return (int8_t)(uint8_t)(seq - base);
+}
+
+// Every receiver channel, whether or not it has been heard from
+static uint8_t all_channels(const morse_lanes_t *lanes)
+{
+    return (uint8_t)((1u << (lanes->channels < MORSE_LANES_MAX ? lanes->channels : MORSE_LANES_MAX)) - 1);
+}
+
+// Each lane delivers its frames in order, so a missing frame can still come
+// as long as some channel that hasn't ended hasn't gone past it (or hasn't
+// been heard from: it may be the lane whose frames are missing)
+static bool may_arrive(const morse_lanes_t *lanes, uint8_t seq)
+{
+    for (int channel = 0; channel < lanes->channels && channel < MORSE_LANES_MAX; channel++) {
+        if (lanes->ended >> channel & 1) {
+            continue;
+        }
+        if (!(lanes->active >> channel & 1) || seq_distance(lanes->last_seq[channel], seq) < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static morse_lanes_slot_t *find_slot(morse_lanes_t *lanes, uint8_t seq)
+{
+    for (int i = 0; i < MORSE_LANES_WINDOW; i++) {
+        if (lanes->slots[i].used && lanes->slots[i].seq == seq) {
+            return &lanes->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t lowest_pending(const morse_lanes_t *lanes)
+{
+    const morse_lanes_slot_t *lowest = NULL;
+    for (int i = 0; i < MORSE_LANES_WINDOW; i++) {
+        const morse_lanes_slot_t *slot = &lanes->slots[i];
+        if (slot->used && (lowest == NULL || seq_distance(slot->seq, lowest->seq) < 0)) {
+            lowest = slot;
+        }
+    }
+    return lowest ? lowest->seq : 0;
+}
+
+// Deliver everything that is in order; a gap is skipped once it can no
+// longer fill (or always when flushing)
+static void deliver(morse_lanes_t *lanes, bool flush)
+{
+    if (!lanes->synced) {
+        // Lockstep lanes finish their first frames in any order: wait until
+        // every channel could have delivered one before picking the start
+        if (lanes->pending == 0 || (!flush && lanes->pending < lanes->channels && lanes->pending < MORSE_LANES_WINDOW)) {
+            return;
+        }
+        lanes->next_seq = lowest_pending(lanes);
+        lanes->synced = true;
+    }
+
+    uint8_t lost = 0;
+    while (lanes->pending > 0) {
+        morse_lanes_slot_t *slot = find_slot(lanes, lanes->next_seq);
+        if (slot == NULL) {
+            if (!flush && may_arrive(lanes, lanes->next_seq) && lanes->pending < MORSE_LANES_WINDOW) {
+                break;
+            }
+            lanes->frames_lost++;
+            lost++;
+            lanes->next_seq++;
+            continue;
+        }
+
+        if (lanes->callback) {
+            lanes->callback(slot->seq, slot->payload, slot->length, lost, lanes->callback_ctx);
+        }
+        lanes->frames_ok++;
+        lost = 0;
+        slot->used = false;
+        lanes->pending--;
+        lanes->next_seq++;
+    }
+}
+
+static void end_stripe(morse_lanes_t *lanes)
+{
+    deliver(lanes, true);
+    lanes->synced = false;
+    lanes->active = 0;
+    lanes->ended = 0;
+}
+
+void morse_lanes_init(morse_lanes_t *lanes, uint8_t channels, morse_lanes_cb_t callback, void *callback_ctx)
+{
+    memset(lanes, 0, sizeof(*lanes));
+    lanes->channels = channels;
+    lanes->callback = callback;
+    lanes->callback_ctx = callback_ctx;
+}
+
+void morse_lanes_put(morse_lanes_t *lanes, uint8_t channel, const morse_frame_t *frame)
+{
+    if (frame->status != MORSE_FRAME_OK || frame->duplicate || channel >= MORSE_LANES_MAX) {
+        return;
+    }
+
+    // Lanes can't start the next transmission before every lane has finished
+    // this one, so the channels still silent were dark for all of it (a
+    // message with fewer frames than lanes)
+    if ((lanes->ended >> channel & 1) && (lanes->ended & lanes->active) == lanes->active) {
+        end_stripe(lanes);
+    }
+
+    if (!(lanes->active >> channel & 1) || seq_distance(frame->seq, lanes->last_seq[channel]) > 0) {
+        lanes->last_seq[channel] = frame->seq;
+    }
+    lanes->active |= (uint8_t)(1u << channel);
+    lanes->ended &= (uint8_t)~(1u << channel);
+
+    // Already delivered (or given up on): a repetition, or a lane running late
+    if ((lanes->synced && seq_distance(frame->seq, lanes->next_seq) < 0) || find_slot(lanes, frame->seq) != NULL) {
+        return;
+    }
+
+    morse_lanes_slot_t *slot = NULL;
+    for (int i = 0; i < MORSE_LANES_WINDOW && slot == NULL; i++) {
+        if (!lanes->slots[i].used) {
+            slot = &lanes->slots[i];
+        }
+    }
+    if (slot == NULL) {
+        return;  // Can't happen: deliver() never leaves the window full
+    }
+
+    slot->used = true;
+    slot->seq = frame->seq;
+    slot->length = frame->length;
+    memcpy(slot->payload, frame->payload, (size_t)frame->length + 1);
+    lanes->pending++;
+    deliver(lanes, false);
+}
+
+void morse_lanes_end(morse_lanes_t *lanes, uint8_t channel)
+{
+    if (channel >= MORSE_LANES_MAX) {
+        return;
+    }
+
+    // Letters differ in length, so lanes keyed in lockstep end at different
+    // times: one that is done says nothing about the ones still sending
+    lanes->ended |= (uint8_t)(1u << channel);
+    if ((lanes->ended & all_channels(lanes)) == all_channels(lanes)) {
+        end_stripe(lanes);
+    } else {
+        deliver(lanes, false);  // Gaps only the ended lanes could have filled are lost now
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Author: Noah Laforet
+ * Paged output buffer
+ */
+
+#include "morse_output.h"
+
+void morse_page_init(morse_page_t *page, morse_page_cb_t callback, void *callback_ctx)
+{
+    page->length = 0;
+    page->callback = callback;
+    page->callback_ctx = callback_ctx;
+}
+
+void morse_page_put(morse_page_t *page, char c)
+{
+    page->data[page->length++] = c;
+    if (page->length == MORSE_PAGE_SIZE) {
+        morse_page_flush(page, false);
+    }
+}
+
+void morse_page_flush(morse_page_t *page, bool end_of_message)
+{
+    if (page->length == 0 && !end_of_message) {
+        return;
+    }
+
+    page->data[page->length] = '\0';
+    if (page->callback) {
+        page->callback(page->data, page->length, end_of_message, page->callback_ctx);
+    }
+    page->length = 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Author: Noah Laforet
+ * Morse decoder speed profiles
+ */
+
+#include <stddef.h>
+#include "morse_profile.h"
+
+static const morse_profile_t morse_profiles[MORSE_PROFILE_COUNT] = {
+    [MORSE_PROFILE_STANDARD] = {
+        .name = "standard",
+        .dot_us = 200000,
+        .glitch_us = 10000,
+        .sample_freq_hz = 10000,
+        .adaptive = true,
+    },
+    [MORSE_PROFILE_FAST] = {
+        .name = "fast",
+        .dot_us = 10000,
+        .glitch_us = 2000,
+        .sample_freq_hz = 20000,
+        .adaptive = true,
+    },
+    [MORSE_PROFILE_ULTRA_FAST] = {
+        .name = "ultra-fast",
+        .dot_us = 2000,
+        .glitch_us = 500,
+        .sample_freq_hz = 50000,
+        .adaptive = true,
+    },
+};
+
+const morse_profile_t *morse_profile_get(morse_profile_id_t id)
+{
+    if (id >= MORSE_PROFILE_COUNT) {
+        return NULL;
+    }
+    return &morse_profiles[id];
+}
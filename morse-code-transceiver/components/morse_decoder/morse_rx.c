@@ -0,0 +1,2141 @@
+/*
+ * Author: Noah Laforet
+ * Morse receiver front end (ESP-IDF)
+ *
+ * Photodiode on ADC1 sampled by the continuous (DMA) driver, or a comparator
+ * on a GPIO captured by interrupt. Either way the producer only timestamps
+ * edges and pushes them through the lock-free edge queue; a lower-priority
+ * task runs the shared decoder state machine and records its events in a
+ * binary log ring, which the lowest-priority task drains to the console.
+ * Decoded characters are streamed to stdout as they resolve and logged in
+ * fixed-size pages, so output memory does not grow with message length.
+ *
+ * With several photodiodes on ADC1 (CONFIG_MORSE_CHANNELS) every channel gets
+ * its own rx_channel_t, from slicer to log slots; edge events and log records
+ * carry the channel number, and the tasks are shared. Frames striped across
+ * several LEDs are put back in sequence order across the channels.
+ *
+ * With CONFIG_MORSE_PERF_STATS each hot-path stage is timed in CPU cycles
+ * (sampler frame, decoder edge and tick, output, log) along with frame
+ * interval jitter, loop overruns and missed or late samples; the "stats"
+ * console command prints them.
+ *
+ * With CONFIG_MORSE_FILE_TRANSFER the chunk frames of a file transfer are
+ * told apart from resends, and the goodput is logged when it completes.
+ *
+ * With CONFIG_MORSE_CAPTURE the sampler also copies every raw sample into
+ * per-channel capture blocks, which a capture task writes to the console for
+ * offline replay (morse_capture.h).
+ *
+ * With CONFIG_MORSE_LIGHT_SLEEP the producer stops sampling once every
+ * decoder is idle and sleeps until the wake GPIO sees light; the first pulse
+ * after a long idle is the transmitter's wake preamble and is not decoded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/stream_buffer.h"
+#include "soc/soc_caps.h"
+#include "esp_log.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_adc/adc_oneshot.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#if CONFIG_MORSE_LIGHT_SLEEP
+#include "esp_sleep.h"
+#include "driver/uart.h"
+#endif
+#if CONFIG_MORSE_PERF_STATS
+#include "esp_cpu.h"
+#include "esp_console.h"
+#endif
+#if CONFIG_MORSE_PERF_STATS || CONFIG_MORSE_ADC_TIMER
+#include "perf_stats.h"
+#endif
+#if CONFIG_MORSE_CAPTURE
+#include "freertos/message_buffer.h"
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#include "driver/uart_vfs.h"
+#include "driver/usb_serial_jtag_vfs.h"
+#else
+#include "esp_vfs_dev.h"
+#endif
+#endif
+#include "edge_queue.h"
+#include "event_log.h"
+#include "morse_decoder.h"
+#include "morse_slicer.h"
+#include "morse_dsp.h"
+#include "morse_output.h"
+#include "morse_frame.h"
+#include "morse_data.h"
+#include "morse_lanes.h"
+#include "morse_transfer.h"
+#include "morse_capture.h"
+#include "morse_rx.h"
+
+const static char *TAG = "MORSE_RECEIVER";
+
+/*---------------------------------------------------------------
+        ADC Configuration for Photodiode
+---------------------------------------------------------------*/
+// ADC1 Channel 2 (GPIO2) - Photodiode input; more photodiodes take the
+// remaining ADC1 pins in this order
+#if CONFIG_IDF_TARGET_ESP32
+#define PHOTODIODE_ADC_CHANNELS     { ADC_CHANNEL_4, ADC_CHANNEL_5, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_0 }
+#else
+#define PHOTODIODE_ADC_CHANNELS     { ADC_CHANNEL_2, ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_3, ADC_CHANNEL_4 }  // ESP32C3: GPIO2, 0, 1, 3, 4
+#endif
+
+#if CONFIG_MORSE_FRONTEND_ADC
+#define RX_CHANNELS                 CONFIG_MORSE_CHANNELS
+#else
+#define RX_CHANNELS                 1       // One comparator
+#endif
+
+#define EXAMPLE_ADC_ATTEN           ADC_ATTEN_DB_12  // 0-3.3V range
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_OUTPUT_TYPE             ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_GET_CHANNEL(p_data)     ((p_data)->type1.channel)
+#define ADC_GET_DATA(p_data)        ((p_data)->type1.data)
+#define ADC_SET_RESULT(p_data, c, d) do { (p_data)->val = 0; (p_data)->type1.channel = (c); (p_data)->type1.data = (d); } while (0)
+#else
+#define ADC_OUTPUT_TYPE             ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_GET_CHANNEL(p_data)     ((p_data)->type2.channel)
+#define ADC_GET_DATA(p_data)        ((p_data)->type2.data)
+#define ADC_SET_RESULT(p_data, c, d) do { (p_data)->val = 0; (p_data)->type2.channel = (c); (p_data)->type2.data = (d); } while (0)
+#endif
+
+/*---------------------------------------------------------------
+        Continuous (DMA) Sampling Configuration
+---------------------------------------------------------------*/
+// The ADC digital controller paces conversions from its own clock and DMA
+// fills frames into the driver's ring buffer, so the sample rate (set by the
+// profile) does not depend on configTICK_RATE_HZ.
+#define ADC_FRAME_SAMPLES           128     // Samples per DMA frame
+#define ADC_FRAME_BYTES             (ADC_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_RING_FRAMES             8       // Frames the driver ring buffer can hold
+#define ADC_READ_TIMEOUT_MS         100     // Block at most this long waiting for a frame
+#define ADC_MIN_SAMPLE_FREQ_HZ      10000
+#define ADC_MAX_SAMPLE_FREQ_HZ      100000
+
+/*---------------------------------------------------------------
+        Timer-Driven Sampling Configuration
+---------------------------------------------------------------*/
+// A gptimer alarm at the exact sample period wakes the sampling task for
+// every sample, independent of configTICK_RATE_HZ. Each wake costs a context
+// switch plus one one-shot conversion per channel, so the rate is capped.
+#define SAMPLE_TIMER_RESOLUTION_HZ  1000000 // 1 us timer ticks: the period is a whole number of us
+#define SAMPLE_TIMER_MAX_HZ         20000   // Conversions per second (all channels)
+
+/*---------------------------------------------------------------
+        Light Slicer Configuration
+---------------------------------------------------------------*/
+// Continuous light longer than this is treated as an ambient change and the
+// slicer re-baselines on it (must exceed MORSE_SPEED_MAX_PULSE_US)
+#define SLICER_MAX_ON_MS            4000
+
+/*---------------------------------------------------------------
+        Task Configuration
+---------------------------------------------------------------*/
+// The sampler only slices and timestamps, the decoder runs the state machine
+// below it, and all console output comes from the log task at the bottom.
+#define SAMPLING_TASK_PRIORITY      10
+#define SAMPLING_TASK_STACK         4096
+#define DECODER_TASK_PRIORITY       5
+#define DECODER_TASK_STACK          4096
+#define EDGE_CAPTURE_TICK_MS        10      // GPIO front end: decoder wakes this often for idle timeouts
+#define GPIO_EDGE_JITTER_US         20      // GPIO front end: interrupt latency budget for the tolerance model
+#define LOG_TASK_PRIORITY           1       // Just above idle: prints whatever the other tasks leave time for
+#define LOG_TASK_STACK              4096
+#define LOG_DRAIN_PERIOD_MS         20      // Log task wakes this often
+#define LOG_DRAIN_BATCH             16      // Records printed per wake (rate limit)
+#define LOG_PAGE_SLOTS              8       // Per channel; a slot is held until its record is printed
+#define LOG_FRAME_SLOTS             4       // Per channel, with room for a 255-character payload each
+#define LOG_DATA_SLOTS              4       // Per channel, likewise
+#define LOG_RECORD_PAGE             0x80    // Log-only record type: a full output page mid-message
+#define LOG_RECORD_FRAME            0x81    // Log-only record type: a frame result (index = slot)
+#define LOG_RECORD_DATA             0x82    // Log-only record type: a data burst result (index = slot)
+#define LOG_RECORD_STRIPE           0x83    // Log-only record type: a reassembled striped frame (index = slot)
+#define LOG_RECORD_WAKE             0x84    // Log-only record type: a skipped wake preamble (duration = part seen)
+#define LOG_RECORD_TRANSFER         0x85    // Log-only record type: a file transfer finished (see transfer_report)
+#define OUTPUT_TASK_PRIORITY        2       // Above the log task: decoded text beats diagnostics
+#define OUTPUT_TASK_STACK           4096
+#define OUTPUT_STREAM_BYTES         512     // Decoded characters buffered for the output task
+#define CPU_CYCLES_PER_US           CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ    // Perf counters: cycles -> us
+#define STATS_PROMPT                "morse>"
+#define MS_FRACTION(us)             (long)((us) / 1000), (long)(((us) % 1000) / 10)    // "%ld.%02ld ms" arguments
+
+#if CONFIG_MORSE_DATA_MODE
+// Data bursts are only expected this many dot times after <SN>
+#define DATA_ARM_TIMEOUT_DOTS       20
+#endif
+
+#if CONFIG_MORSE_CAPTURE
+/*---------------------------------------------------------------
+        Capture Configuration
+---------------------------------------------------------------*/
+// Blocks wait here for the capture task; a block that doesn't fit is dropped
+// whole, so the console only ever sees complete blocks
+#define CAPTURE_BUFFER_BYTES        8192    // About 20 blocks: 250 ms at 20 kS/s
+#define CAPTURE_TASK_PRIORITY       3       // Above output and log: capture mode is for the samples
+#define CAPTURE_TASK_STACK          3072
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+/*---------------------------------------------------------------
+        Light Sleep Configuration
+---------------------------------------------------------------*/
+#if CONFIG_MORSE_FRONTEND_GPIO
+#define WAKE_GPIO                   CONFIG_MORSE_EDGE_GPIO
+#else
+#define WAKE_GPIO                   CONFIG_MORSE_WAKE_GPIO
+#endif
+#define SLEEP_IDLE_US               ((int64_t)CONFIG_MORSE_SLEEP_IDLE_MS * 1000)
+#define SLEEP_DRAIN_TIMEOUT_MS      500     // Longest wait for the log and output tasks before sleeping
+#define SLEEP_DRAIN_POLL_MS         10
+#define UART_WAKE_THRESHOLD         3       // Console RX edges that wake the chip (that keystroke is lost)
+#endif
+
+// One photodiode's receive chain. The sampling task owns the sample clock,
+// filter and slicer; everything from the decoder down belongs to the decoder
+// task, and the log task only reads the slots it was handed.
+typedef struct {
+    uint8_t id;                                 // Index in channels[], tags its events and log lines
+#if CONFIG_MORSE_FRONTEND_ADC
+    adc_channel_t adc_channel;
+    int64_t sample_count;                       // This channel's sample clock
+    morse_slicer_t slicer;
+#if CONFIG_MORSE_DSP
+    morse_dsp_t dsp;                            // Matched filter ahead of the slicer
+    bool dsp_primed;
+#endif
+    adc_cali_handle_t cali_handle;
+    bool calibrated;
+#if CONFIG_MORSE_CAPTURE
+    morse_capture_t capture;                    // Raw samples for the host, one block at a time
+#endif
+#endif
+    morse_decoder_t decoder;
+    morse_page_t output_page;                   // Decoded text for the log, one page at a time
+    char page_slots[LOG_PAGE_SLOTS][MORSE_PAGE_SIZE + 1];   // Page text kept until the log task prints it
+    event_log_slots_t page_claims;
+    int64_t page_time_us;                       // Time of the event that completed the page
+    morse_frame_parser_t frame_parser;          // Framed mode, fed with every decoded character
+    morse_frame_t frame_slots[LOG_FRAME_SLOTS]; // Frame results kept until the log task prints them
+    char frame_payloads[LOG_FRAME_SLOTS][MORSE_FRAME_PAYLOAD_MAX + 1];
+    event_log_slots_t frame_claims;
+#if CONFIG_MORSE_DATA_MODE
+    morse_data_t data_rx;                       // Manchester bit slicer, active between <SN> and the CRC
+    morse_data_frame_t data_slots[LOG_DATA_SLOTS];  // Burst results kept until the log task prints them
+    char data_payloads[LOG_DATA_SLOTS][MORSE_DATA_PAYLOAD_MAX + 1];
+    event_log_slots_t data_claims;
+#endif
+#if CONFIG_MORSE_FILE_TRANSFER
+    morse_transfer_t transfer;                  // Chunks of the file transfer in progress
+    struct {
+        uint16_t received;
+        uint16_t chunks;
+        uint32_t bytes_received;
+        uint32_t bytes;
+        uint32_t frames;
+        uint32_t goodput;                       // Bytes/s
+        int64_t elapsed_us;
+    } transfer_report;                          // Copy of a finished transfer for the log task
+    event_log_slots_t transfer_claims;          // The one report slot
+#endif
+#if CONFIG_MORSE_LIGHT_SLEEP
+    int64_t last_edge_us;                       // Decoder task: time of the last rise or fall
+    int64_t preamble_start_us;                  // Rise of the wake preamble being skipped, or -1
+    int64_t preamble_resume_us;                 // Sampling resumed -> preamble rise, or -1 if awake (log slot)
+#endif
+} rx_channel_t;
+
+static const morse_profile_t *rx_profile;
+static rx_channel_t channels[RX_CHANNELS];
+static edge_queue_t edge_queue;                 // Sampler -> decoder edge events
+static TaskHandle_t decoder_task_handle = NULL;
+static event_log_t event_log;                   // Decoder -> log task records
+static volatile int log_verbosity = CONFIG_MORSE_LOG_VERBOSITY;
+#if RX_CHANNELS > 1
+static morse_lanes_t lanes;                     // Striped frames from all channels, back in order
+static struct {
+    uint8_t seq;
+    uint8_t lost;                               // Frames given up on just before this one
+    char payload[MORSE_FRAME_PAYLOAD_MAX + 1];
+} stripe_slots[MORSE_LANES_WINDOW];             // A flush can deliver a whole window at once
+static event_log_slots_t stripe_claims;
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+// Written by the task that sleeps: the sampler, or the decoder on the GPIO front end
+static volatile int64_t last_wake_us = -1;      // Decoder clock when sampling last resumed (-1: never slept)
+static volatile bool decoders_idle = false;     // Decoder task: no channel has anything pending
+static struct {
+    uint32_t count;
+    uint32_t console_wakes;                     // Woken by a keystroke rather than light
+    int64_t asleep_us;
+} sleep_stats;
+
+static int64_t light_sleep_until_light(void);
+#if CONFIG_MORSE_FRONTEND_GPIO
+static void edge_light_sleep(void);
+#endif
+#endif
+
+#if CONFIG_MORSE_FRONTEND_GPIO
+static volatile int edge_last_level = 0;        // Comparator level after the last reported edge
+#endif
+
+#if CONFIG_MORSE_PERF_STATS || CONFIG_MORSE_ADC_TIMER
+// Moved on by "stats reset"; starts ahead of the zeroed stages so each writer clears its own at the first sample
+static volatile uint32_t perf_generation = 1;
+#endif
+
+#if CONFIG_MORSE_PERF_STATS
+// Hot-path counters; every stage and count has a single writer task, and a reset never writes them (see perf_stats.h)
+static struct {
+#if CONFIG_MORSE_FRONTEND_ADC
+    perf_stage_t frame;                         // Sampling task: cycles to slice and queue one DMA frame
+    perf_stage_t frame_interval;                // us between frames returned by the driver
+    perf_stage_t frame_jitter;                  // |interval - frame period| in us
+    uint32_t overruns;                          // Frames that took longer to process than to sample
+    uint32_t late_frames;                       // Frames already waiting in the driver ring when read
+    uint32_t overruns_base;                     // overruns at the last reset
+    uint32_t late_frames_base;                  // late_frames at the last reset
+    uint32_t adc_overflow_base;                 // adc_overflow_count at the last reset
+#if CONFIG_MORSE_ADC_TIMER
+    uint32_t timer_missed_base;                 // sample_timer_missed at the last reset
+#endif
+#else
+    perf_stage_t edge_latency;                  // us from the edge interrupt to the decoder task
+    perf_stage_t tick_jitter;                   // Idle wake-up error against EDGE_CAPTURE_TICK_MS, us
+#endif
+    perf_stage_t decode_edge;                   // Decoder task: cycles per rise/fall (pulse/gap timing)
+    perf_stage_t decode_tick;                   // Decoder task: cycles per tick (timeouts, letter decode, output)
+    perf_stage_t output;                        // Output task: cycles per stdout write
+    perf_stage_t log;                           // Log task: cycles per printed record
+#if CONFIG_MORSE_LIGHT_SLEEP
+    perf_stage_t wake_latency;                  // us of the wake preamble lost to waking up and resuming
+#endif
+    unsigned queue_overflow_base;               // Edge queue overflows at the last reset
+    unsigned log_drop_base;                     // Event log drops at the last reset
+    int64_t since_us;                           // Time of the last reset
+} perf;
+#endif
+
+// Log line prefix; a single photodiode keeps the untagged output
+static const char *channel_tag(uint8_t channel)
+{
+    static const char *const tags[] = {"[ch0] ", "[ch1] ", "[ch2] ", "[ch3] ", "[ch4] "};
+    return (RX_CHANNELS > 1 && channel < sizeof(tags) / sizeof(tags[0])) ? tags[channel] : "";
+}
+
+#if CONFIG_MORSE_OUTPUT_STREAM
+static StreamBufferHandle_t output_stream;      // Decoder -> output task characters
+static volatile uint32_t output_dropped = 0;    // Characters lost because the output task fell behind
+#endif
+
+#if CONFIG_MORSE_FRONTEND_ADC
+// DMA frame buffer; each channel counts its own samples (the sample clock)
+static uint8_t adc_frame[ADC_FRAME_BYTES] = {0};
+static uint32_t sample_freq_hz;                 // Per channel
+static volatile uint32_t adc_overflow_count = 0;  // Frames dropped because the ring buffer was full
+static rx_channel_t *adc_channel_map[SOC_ADC_MAX_CHANNEL_NUM];  // ADC1 channel -> receiver channel
+
+#if CONFIG_MORSE_ADC_TIMER
+typedef adc_oneshot_unit_handle_t adc_source_t;
+static gptimer_handle_t sample_timer = NULL;
+static TaskHandle_t sampling_task_handle = NULL;
+static uint32_t sample_period_us;
+static volatile uint32_t sample_timer_missed = 0;  // Alarms the sampling task was too late for
+static perf_stage_t sample_jitter;              // |measured - nominal period| in us (sampling task only)
+static perf_stage_t sample_latency;             // us from alarm to conversion (sampling task only)
+#else
+typedef adc_continuous_handle_t adc_source_t;
+#endif
+
+static bool example_adc_calibration_init(adc_unit_t unit, adc_channel_t channel, adc_atten_t atten, adc_cali_handle_t *out_handle);
+
+#if CONFIG_MORSE_CAPTURE
+static MessageBufferHandle_t capture_buffer;    // Sampler -> capture task blocks
+static volatile uint32_t capture_dropped = 0;   // Blocks lost because the console fell behind
+#endif
+#endif
+
+/*---------------------------------------------------------------
+        Profiles
+---------------------------------------------------------------*/
+const morse_profile_t *morse_profile_default(void)
+{
+#if CONFIG_MORSE_PROFILE_STANDARD
+    return morse_profile_get(MORSE_PROFILE_STANDARD);
+#elif CONFIG_MORSE_PROFILE_ULTRA_FAST
+    return morse_profile_get(MORSE_PROFILE_ULTRA_FAST);
+#else
+    return morse_profile_get(MORSE_PROFILE_FAST);
+#endif
+}
+
+#if CONFIG_MORSE_FRONTEND_ADC
+/*---------------------------------------------------------------
+        Light Level Logging
+---------------------------------------------------------------*/
+static int raw_to_mv(const rx_channel_t *channel, int raw)
+{
+    int voltage = 0;
+    if (!channel->calibrated || adc_cali_raw_to_voltage(channel->cali_handle, raw, &voltage) != ESP_OK) {
+        return -1;
+    }
+    return voltage;
+}
+
+// Slicer fields are read from the decoder task for logging only
+static void log_light_levels(const rx_channel_t *channel, const char *label)
+{
+    const morse_slicer_t *slicer = &channel->slicer;
+    const char *tag = channel_tag(channel->id);
+
+    if (!slicer->adaptive) {
+        ESP_LOGI(TAG, "%s%s: fixed threshold %ld (raw ADC value)", tag, label, (long)slicer->on_threshold);
+        return;
+    }
+
+    int32_t low = morse_slicer_low(slicer);
+    int32_t high = morse_slicer_high(slicer);
+    if (channel->calibrated) {
+        ESP_LOGI(TAG, "%s%s: off %ld (%d mV), on %ld (%d mV), threshold %ld/%ld",
+                 tag, label, (long)low, raw_to_mv(channel, low), (long)high, raw_to_mv(channel, high),
+                 (long)slicer->off_threshold, (long)slicer->on_threshold);
+    } else {
+        ESP_LOGI(TAG, "%s%s: off %ld, on %ld, threshold %ld/%ld (raw ADC values)",
+                 tag, label, (long)low, (long)high, (long)slicer->off_threshold, (long)slicer->on_threshold);
+    }
+}
+
+#if CONFIG_MORSE_ADC_TIMER
+// Measured timer behaviour, logged with every completed message
+static void log_sample_timer(void)
+{
+    perf_stage_t jitter = perf_stage_read(&sample_jitter, perf_generation);
+    perf_stage_t latency = perf_stage_read(&sample_latency, perf_generation);
+    if (jitter.count == 0 || latency.count == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "Sample timer: %lu us period, jitter avg %lu max %lu us, latency max %lu us, %lu alarm(s) missed",
+             (unsigned long)sample_period_us, (unsigned long)(jitter.total / jitter.count), (unsigned long)jitter.max,
+             (unsigned long)latency.max, (unsigned long)sample_timer_missed);
+}
+#endif
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+static void log_light_sleep(void)
+{
+    int64_t asleep_ms = sleep_stats.asleep_us / 1000;
+    int64_t awake_ms = esp_timer_get_time() / 1000 - asleep_ms;
+    ESP_LOGI(TAG, "Light sleep: %lu wake-up(s) (%lu from the console), %lld.%01lld s asleep, %lld.%01lld s awake",
+             (unsigned long)sleep_stats.count, (unsigned long)sleep_stats.console_wakes,
+             asleep_ms / 1000, asleep_ms / 100 % 10, awake_ms / 1000, awake_ms / 100 % 10);
+}
+#endif
+
+/*---------------------------------------------------------------
+        Decoder Events (recorded in O(1), printed by the log task)
+---------------------------------------------------------------*/
+static int event_verbosity(morse_event_type_t type)
+{
+    switch (type) {
+    case MORSE_EVENT_MESSAGE:
+        return MORSE_LOG_MESSAGES;
+    case MORSE_EVENT_CHAR:
+        return MORSE_LOG_CHARS;
+    default:
+        return MORSE_LOG_SYMBOLS;
+    }
+}
+
+static void stream_write(const char *data, size_t length)
+{
+#if CONFIG_MORSE_OUTPUT_STREAM
+    size_t sent = xStreamBufferSend(output_stream, data, length, 0);
+    if (sent != length) {
+        output_dropped += length - sent;
+    }
+#endif
+}
+
+// A single channel streams characters as they resolve; several would
+// interleave, so they stream whole pages instead (see log_page)
+static void stream_char(char c)
+{
+    if (RX_CHANNELS == 1) {
+        stream_write(&c, 1);
+    }
+}
+
+static void stream_line(const rx_channel_t *channel, const char *data, size_t length)
+{
+    if (RX_CHANNELS > 1 && length > 0) {
+        const char *tag = channel_tag(channel->id);
+        stream_write(tag, strlen(tag));
+        stream_write(data, length);
+        stream_write("\n", 1);
+    }
+}
+
+static void log_page(const char *data, size_t length, bool end_of_message, void *ctx)
+{
+    rx_channel_t *channel = ctx;
+
+    stream_line(channel, data, length);
+
+    // The page is reused straight away; keep a copy for the log task
+    int slot = event_log_slot_next(&event_log, &channel->page_claims, LOG_PAGE_SLOTS);
+    if (slot < 0) {
+        return;
+    }
+    memcpy(channel->page_slots[slot], data, length + 1);
+
+    event_log_record_t record = {
+        .time_us = channel->page_time_us,
+        .duration_us = morse_speed_dot_us(&channel->decoder.speed),
+        .type = end_of_message ? MORSE_EVENT_MESSAGE : LOG_RECORD_PAGE,
+        .index = (uint8_t)slot,
+        .channel = channel->id,
+    };
+    event_log_write_slot(&event_log, &channel->page_claims, &record);
+}
+
+static void log_frame(const morse_frame_t *frame, void *ctx)
+{
+    rx_channel_t *channel = ctx;
+    int slot = event_log_slot_next(&event_log, &channel->frame_claims, LOG_FRAME_SLOTS);
+
+    if (slot >= 0) {
+        channel->frame_slots[slot] = *frame;
+        channel->frame_payloads[slot][0] = '\0';
+        if (frame->status == MORSE_FRAME_OK) {
+            memcpy(channel->frame_payloads[slot], frame->payload, (size_t)frame->length + 1);
+        }
+    }
+
+    morse_transfer_result_t transfer = MORSE_TRANSFER_NONE;
+#if CONFIG_MORSE_FILE_TRANSFER
+    if (frame->status == MORSE_FRAME_OK) {
+        transfer = morse_transfer_put(&channel->transfer, frame->payload, frame->length, channel->page_time_us);
+    }
+#endif
+
+    event_log_record_t record = {
+        .time_us = channel->page_time_us,
+        .duration_us = morse_speed_dot_us(&channel->decoder.speed),
+        .type = LOG_RECORD_FRAME,
+        .index = (uint8_t)slot,
+        .ch = (char)transfer,
+        .channel = channel->id,
+    };
+    if (slot >= 0) {
+        event_log_write_slot(&event_log, &channel->frame_claims, &record);
+    }
+
+#if CONFIG_MORSE_FILE_TRANSFER
+    if ((transfer == MORSE_TRANSFER_DONE || transfer == MORSE_TRANSFER_ENDED) &&
+        event_log_slot_next(&event_log, &channel->transfer_claims, 1) >= 0) {
+        const morse_transfer_t *state = &channel->transfer;
+        channel->transfer_report.received = state->received;
+        channel->transfer_report.chunks = state->chunks;
+        channel->transfer_report.bytes_received = state->bytes_received;
+        channel->transfer_report.bytes = state->bytes;
+        channel->transfer_report.frames = state->frames;
+        channel->transfer_report.goodput = morse_transfer_goodput(state);
+        channel->transfer_report.elapsed_us = state->last_us - state->start_us;
+        record.type = LOG_RECORD_TRANSFER;
+        record.index = 0;
+        event_log_write_slot(&event_log, &channel->transfer_claims, &record);
+    }
+#endif
+
+#if RX_CHANNELS > 1
+    morse_lanes_put(&lanes, channel->id, frame);
+#endif
+}
+
+#if RX_CHANNELS > 1
+static void log_stripe(uint8_t seq, const char *payload, uint8_t length, uint8_t lost, void *ctx)
+{
+    static const char tag[] = "[lanes] ";
+
+    stream_write(tag, sizeof(tag) - 1);
+    stream_write(payload, length);
+    stream_write("\n", 1);
+
+    int slot = event_log_slot_next(&event_log, &stripe_claims, MORSE_LANES_WINDOW);
+    if (slot < 0) {
+        return;
+    }
+    stripe_slots[slot].seq = seq;
+    stripe_slots[slot].lost = lost;
+    memcpy(stripe_slots[slot].payload, payload, (size_t)length + 1);
+
+    event_log_record_t record = {
+        .type = LOG_RECORD_STRIPE,
+        .index = (uint8_t)slot,
+    };
+    event_log_write_slot(&event_log, &stripe_claims, &record);
+}
+#endif
+
+static const char *frame_status_name(morse_frame_status_t status)
+{
+    switch (status) {
+    case MORSE_FRAME_OK:
+        return "OK";
+    case MORSE_FRAME_BAD_CRC:
+        return "CRC error";
+    case MORSE_FRAME_BAD_HEADER:
+        return "bad header";
+    case MORSE_FRAME_BAD_LENGTH:
+        return "bad length";
+    case MORSE_FRAME_UNCORRECTABLE:
+        return "too many errors to correct";
+    default:
+        return "truncated";
+    }
+}
+
+#if CONFIG_MORSE_LINK_REPORT
+// One word per status, for the @link report lines
+static const char *frame_status_token(morse_frame_status_t status)
+{
+    switch (status) {
+    case MORSE_FRAME_OK:
+        return "ok";
+    case MORSE_FRAME_BAD_CRC:
+        return "crc";
+    case MORSE_FRAME_BAD_HEADER:
+        return "header";
+    case MORSE_FRAME_BAD_LENGTH:
+        return "length";
+    case MORSE_FRAME_UNCORRECTABLE:
+        return "fec";
+    default:
+        return "truncated";
+    }
+}
+#endif
+
+#if CONFIG_MORSE_DATA_MODE
+static const char *data_status_name(morse_data_status_t status)
+{
+    switch (status) {
+    case MORSE_DATA_OK:
+        return "OK";
+    case MORSE_DATA_BAD_CRC:
+        return "CRC error";
+    case MORSE_DATA_NO_SYNC:
+        return "no sync";
+    default:
+        return "lost clock";
+    }
+}
+
+static void log_data(const morse_data_frame_t *frame, void *ctx)
+{
+    rx_channel_t *channel = ctx;
+
+    for (uint8_t i = 0; i < frame->length; i++) {
+        stream_char((char)frame->payload[i]);  // Payload bytes go out unchanged
+    }
+    if (frame->status == MORSE_DATA_OK) {
+        stream_char('\n');
+        stream_line(channel, (const char *)frame->payload, frame->length);
+    }
+
+    int slot = event_log_slot_next(&event_log, &channel->data_claims, LOG_DATA_SLOTS);
+    if (slot < 0) {
+        return;
+    }
+    channel->data_slots[slot] = *frame;
+    for (uint8_t i = 0; i < frame->length; i++) {
+        char c = (char)frame->payload[i];
+        channel->data_payloads[slot][i] = (c >= ' ' && c <= '~') ? c : '.';
+    }
+    channel->data_payloads[slot][frame->length] = '\0';
+
+    event_log_record_t record = {
+        .time_us = channel->page_time_us,
+        .type = LOG_RECORD_DATA,
+        .index = (uint8_t)slot,
+        .channel = channel->id,
+    };
+    event_log_write_slot(&event_log, &channel->data_claims, &record);
+}
+#endif
+
+static void handle_decoder_event(const morse_event_t *event, void *ctx)
+{
+    rx_channel_t *channel = ctx;
+
+    channel->page_time_us = event->time_us;
+
+    if (event->type == MORSE_EVENT_CHAR) {
+#if CONFIG_MORSE_DATA_MODE
+        if (event->ch == MORSE_DATA_START) {
+            // Edges from here on go to the bit slicer (see process_edge_event)
+            morse_data_start(&channel->data_rx, event->time_us,
+                             (int64_t)DATA_ARM_TIMEOUT_DOTS * morse_speed_dot_us(&channel->decoder.speed));
+        }
+#endif
+        morse_frame_put(&channel->frame_parser, event->ch);
+        // Frame payloads may be keyed in another code table; the next letter
+        // hasn't resolved yet, so switching here is always in time
+        morse_decoder_set_table(&channel->decoder, morse_frame_table(&channel->frame_parser));
+        if ((unsigned char)event->ch >= ' ') {  // Prosigns only delimit frames
+            stream_char(event->ch);
+            morse_page_put(&channel->output_page, event->ch);
+        }
+    } else if (event->type == MORSE_EVENT_MESSAGE) {
+        morse_frame_end(&channel->frame_parser);
+#if RX_CHANNELS > 1
+        morse_lanes_end(&lanes, channel->id);
+#endif
+        morse_decoder_set_table(&channel->decoder, 0);
+        stream_char('\n');
+        morse_page_flush(&channel->output_page, true);  // Logs the end of the message
+        return;
+    }
+
+    if (event_verbosity(event->type) > log_verbosity) {
+        return;
+    }
+
+    event_log_record_t record = {
+        .time_us = event->time_us,
+        .duration_us = (int32_t)(event->duration_us < INT32_MAX ? event->duration_us : INT32_MAX),
+        .type = event->type,
+        .index = event->index,
+        .ch = event->ch,
+        .channel = channel->id,
+    };
+    event_log_write(&event_log, &record);
+}
+
+// The log task is done with a record: free the payload slot it held
+static void release_record(const event_log_record_t *record)
+{
+    rx_channel_t *channel = &channels[record->channel];
+
+    switch (record->type) {
+    case LOG_RECORD_PAGE:
+    case MORSE_EVENT_MESSAGE:
+        event_log_slot_release(&channel->page_claims);
+        break;
+    case LOG_RECORD_FRAME:
+        event_log_slot_release(&channel->frame_claims);
+        break;
+#if RX_CHANNELS > 1
+    case LOG_RECORD_STRIPE:
+        event_log_slot_release(&stripe_claims);
+        break;
+#endif
+#if CONFIG_MORSE_DATA_MODE
+    case LOG_RECORD_DATA:
+        event_log_slot_release(&channel->data_claims);
+        break;
+#endif
+#if CONFIG_MORSE_FILE_TRANSFER
+    case LOG_RECORD_TRANSFER:
+        event_log_slot_release(&channel->transfer_claims);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+static void print_record(const event_log_record_t *record)
+{
+    char pattern[MORSE_PATTERN_MAX];
+    const rx_channel_t *channel = &channels[record->channel];
+    const char *tag = channel_tag(record->channel);
+
+    switch (record->type) {
+    case MORSE_EVENT_DOT:
+        ESP_LOGI(TAG, "%sDot detected (%ld.%02ld ms)", tag, MS_FRACTION(record->duration_us));
+        break;
+    case MORSE_EVENT_DASH:
+        ESP_LOGI(TAG, "%sDash detected (%ld.%02ld ms)", tag, MS_FRACTION(record->duration_us));
+        break;
+    case MORSE_EVENT_LETTER_GAP:
+        ESP_LOGI(TAG, "%sLetter gap detected (%ld.%02ld ms)", tag, MS_FRACTION(record->duration_us));
+        break;
+    case MORSE_EVENT_WORD_GAP:
+        ESP_LOGI(TAG, "%sWord gap detected (%ld.%02ld ms)", tag, MS_FRACTION(record->duration_us));
+        break;
+    case MORSE_EVENT_CHAR:
+        if (record->index != 0) {  // Spaces already show up as word gaps
+            ESP_LOGI(TAG, "%s  → Decoded: '%s' = '%c'", tag, morse_index_pattern(record->index, pattern), record->ch);
+        }
+        break;
+    case LOG_RECORD_PAGE:
+        ESP_LOGI(TAG, "%sOutput: %s", tag, channel->page_slots[record->index]);
+        break;
+    case LOG_RECORD_FRAME: {
+        const morse_frame_t *frame = &channel->frame_slots[record->index];
+        const morse_frame_parser_t *parser = &channel->frame_parser;
+        if (frame->status == MORSE_FRAME_OK) {
+            const char *table = morse_table_name(frame->table);
+            ESP_LOGI(TAG, "%sFrame #%02X OK%s (%s code, %u corrected): %s", tag, frame->seq, frame->duplicate ? " (repeat)" : "",
+                     table ? table : "?", frame->corrected, channel->frame_payloads[record->index]);
+        } else {
+            ESP_LOGW(TAG, "%sFrame #%02X failed: %s", tag, frame->seq, frame_status_name(frame->status));
+        }
+        ESP_LOGI(TAG, "%sFrames: %lu OK, %lu failed, %lu symbols corrected", tag, (unsigned long)parser->frames_ok,
+                 (unsigned long)parser->frames_bad, (unsigned long)parser->symbols_corrected);
+#if CONFIG_MORSE_LINK_REPORT
+        // Read back by the transmitter's link-rate search (transmitter/src/morse_autobaud.py)
+        printf("@link %u %02X %s %ld %u\n", record->channel, frame->seq, frame_status_token(frame->status),
+               (long)record->duration_us, frame->corrected);
+#if CONFIG_MORSE_FILE_TRANSFER
+        // Start and new chunks only, so a console capture rebuilds the file (morse_transfer.py --rebuild)
+        if (record->ch == MORSE_TRANSFER_STARTED || record->ch == MORSE_TRANSFER_CHUNK || record->ch == MORSE_TRANSFER_DONE) {
+            printf("@chunk %s\n", channel->frame_payloads[record->index]);
+        }
+#endif
+        fflush(stdout);
+#endif
+        break;
+    }
+#if RX_CHANNELS > 1
+    case LOG_RECORD_STRIPE:
+        if (stripe_slots[record->index].lost) {
+            ESP_LOGW(TAG, "[lanes] %u frame(s) lost before #%02X", stripe_slots[record->index].lost,
+                     stripe_slots[record->index].seq);
+        }
+        ESP_LOGI(TAG, "[lanes] #%02X: %s", stripe_slots[record->index].seq, stripe_slots[record->index].payload);
+        ESP_LOGI(TAG, "[lanes] %lu frames in order, %lu lost", (unsigned long)lanes.frames_ok, (unsigned long)lanes.frames_lost);
+        break;
+#endif
+#if CONFIG_MORSE_DATA_MODE
+    case LOG_RECORD_DATA: {
+        const morse_data_frame_t *frame = &channel->data_slots[record->index];
+        unsigned long bit_rate = frame->half_bit_us ? 500000UL / (unsigned long)frame->half_bit_us : 0;
+        if (frame->status == MORSE_DATA_OK) {
+            unsigned long byte_rate = frame->duration_us ? (unsigned long)(frame->length * 1000000LL / frame->duration_us) : 0;
+            ESP_LOGI(TAG, "%sData burst OK: %u bytes at %lu bit/s (%lu bytes/s): %s",
+                     tag, frame->length, bit_rate, byte_rate, channel->data_payloads[record->index]);
+        } else {
+            ESP_LOGW(TAG, "%sData burst failed: %s (%lu bit/s)", tag, data_status_name(frame->status), bit_rate);
+        }
+        ESP_LOGI(TAG, "%sData bursts: %lu OK, %lu failed", tag, (unsigned long)channel->data_rx.frames_ok,
+                 (unsigned long)channel->data_rx.frames_bad);
+        break;
+    }
+#endif
+#if CONFIG_MORSE_FILE_TRANSFER
+    case LOG_RECORD_TRANSFER: {
+        const int64_t elapsed_ms = channel->transfer_report.elapsed_us / 1000;
+        if (channel->transfer_report.received == channel->transfer_report.chunks) {
+            ESP_LOGI(TAG, "%sTransfer complete: %lu bytes in %lld.%03lld s, %lu bytes/s goodput (%u chunks, %lu frames)",
+                     tag, (unsigned long)channel->transfer_report.bytes_received, elapsed_ms / 1000, elapsed_ms % 1000,
+                     (unsigned long)channel->transfer_report.goodput, channel->transfer_report.chunks,
+                     (unsigned long)channel->transfer_report.frames);
+        } else {
+            ESP_LOGW(TAG, "%sTransfer ended with %u of %u chunks (%lu of %lu bytes) after %lld.%03lld s",
+                     tag, channel->transfer_report.received, channel->transfer_report.chunks,
+                     (unsigned long)channel->transfer_report.bytes_received, (unsigned long)channel->transfer_report.bytes,
+                     elapsed_ms / 1000, elapsed_ms % 1000);
+        }
+        break;
+    }
+#endif
+#if CONFIG_MORSE_LIGHT_SLEEP
+    case LOG_RECORD_WAKE: {
+        int32_t lost_us = CONFIG_MORSE_WAKE_PREAMBLE_MS * 1000 - record->duration_us;
+        if (channel->preamble_resume_us < 0) {
+            ESP_LOGI(TAG, "%sWake preamble skipped: %ld.%02ld of %d ms (receiver was awake)",
+                     tag, MS_FRACTION(record->duration_us), CONFIG_MORSE_WAKE_PREAMBLE_MS);
+            break;
+        }
+        ESP_LOGI(TAG, "%sWake preamble skipped: %ld.%02ld of %d ms, wake-to-first-edge %ld.%02ld ms (%ld.%02ld ms after sampling resumed)",
+                 tag, MS_FRACTION(record->duration_us), CONFIG_MORSE_WAKE_PREAMBLE_MS, MS_FRACTION(lost_us > 0 ? lost_us : 0),
+                 MS_FRACTION(channel->preamble_resume_us));
+        if (lost_us * 2 > CONFIG_MORSE_WAKE_PREAMBLE_MS * 1000) {
+            ESP_LOGW(TAG, "%sWaking up took over half the preamble; lengthen --wake-preamble-ms", tag);
+        }
+        break;
+    }
+#endif
+    case MORSE_EVENT_MESSAGE:
+        ESP_LOGI(TAG, "");
+        ESP_LOGI(TAG, "================================");
+        ESP_LOGI(TAG, "   %sTransmission Complete!", tag);
+        ESP_LOGI(TAG, "================================");
+        ESP_LOGI(TAG, "Output: %s", channel->page_slots[record->index]);
+        ESP_LOGI(TAG, "Speed: ~%ld WPM (dot %ld.%02ld ms)", (long)((1200000 + record->duration_us / 2) / record->duration_us),
+                 MS_FRACTION(record->duration_us));
+#if CONFIG_MORSE_FRONTEND_ADC
+        log_light_levels(channel, "Light levels");
+#endif
+#if CONFIG_MORSE_ADC_TIMER
+        log_sample_timer();
+#endif
+#if CONFIG_MORSE_LIGHT_SLEEP
+        log_light_sleep();
+#endif
+        ESP_LOGI(TAG, "================================");
+        ESP_LOGI(TAG, "");
+        break;
+    }
+}
+
+void morse_rx_set_log_verbosity(morse_log_verbosity_t verbosity)
+{
+    log_verbosity = verbosity;
+}
+
+#if CONFIG_MORSE_OUTPUT_STREAM
+/*---------------------------------------------------------------
+        Output Task - streams decoded text to stdout
+---------------------------------------------------------------*/
+// stdout is the console (UART or USB-Serial-JTAG, per the console config).
+// Characters arrive here as soon as each letter resolves.
+static void output_task(void *arg)
+{
+    char chunk[32];
+
+    while (1) {
+        size_t length = xStreamBufferReceive(output_stream, chunk, sizeof(chunk), portMAX_DELAY);
+#if CONFIG_MORSE_PERF_STATS
+        uint32_t start = esp_cpu_get_cycle_count();
+#endif
+        fwrite(chunk, 1, length, stdout);
+        fflush(stdout);
+#if CONFIG_MORSE_PERF_STATS
+        perf_stage_add(&perf.output, perf_generation, esp_cpu_get_cycle_count() - start);
+#endif
+    }
+}
+#endif
+
+#if CONFIG_MORSE_CAPTURE
+/*---------------------------------------------------------------
+        Capture Task - writes capture blocks to the console
+---------------------------------------------------------------*/
+// Binary blocks must reach the host byte for byte: no LF -> CRLF
+static void capture_console_lf(void)
+{
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    usb_serial_jtag_vfs_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+#else
+    esp_vfs_dev_usb_serial_jtag_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+#endif
+#elif CONFIG_ESP_CONSOLE_UART
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#else
+    esp_vfs_dev_uart_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#endif
+#endif
+}
+
+static void capture_task(void *arg)
+{
+    static uint8_t block[MORSE_CAPTURE_BLOCK_MAX];
+
+    while (1) {
+        size_t length = xMessageBufferReceive(capture_buffer, block, sizeof(block) - MORSE_CAPTURE_CRC_BYTES,
+                                              portMAX_DELAY);
+        if (length == 0) {
+            continue;
+        }
+        length = morse_capture_seal(block, length);
+        // One locked write per block, so log lines only ever fall between blocks
+        fwrite(block, 1, length, stdout);
+        fflush(stdout);
+    }
+}
+#endif
+
+/*---------------------------------------------------------------
+        Log Task - drains the event log to the console
+---------------------------------------------------------------*/
+static void log_task(void *arg)
+{
+#if CONFIG_MORSE_FRONTEND_ADC
+    uint32_t reported_adc_overflows = 0;
+#endif
+#if CONFIG_MORSE_ADC_TIMER
+    uint32_t reported_timer_misses = 0;
+#endif
+#if CONFIG_MORSE_CAPTURE
+    uint32_t reported_capture_drops = 0;
+#endif
+    unsigned reported_queue_overflows = 0;
+    unsigned reported_drops = 0;
+#if CONFIG_MORSE_OUTPUT_STREAM
+    uint32_t reported_output_drops = 0;
+#endif
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+
+        event_log_record_t record;
+        for (int i = 0; i < LOG_DRAIN_BATCH && event_log_read(&event_log, &record); i++) {
+#if CONFIG_MORSE_PERF_STATS
+            uint32_t start = esp_cpu_get_cycle_count();
+            print_record(&record);
+            perf_stage_add(&perf.log, perf_generation, esp_cpu_get_cycle_count() - start);
+#else
+            print_record(&record);
+#endif
+            release_record(&record);
+        }
+
+        unsigned drops = event_log_dropped_count(&event_log);
+        if (drops != reported_drops) {
+            ESP_LOGW(TAG, "Event log full: %u record(s) dropped", drops - reported_drops);
+            reported_drops = drops;
+        }
+
+#if CONFIG_MORSE_OUTPUT_STREAM
+        if (output_dropped != reported_output_drops) {
+            ESP_LOGW(TAG, "Output stream full: %lu character(s) dropped", (unsigned long)(output_dropped - reported_output_drops));
+            reported_output_drops = output_dropped;
+        }
+#endif
+#if CONFIG_MORSE_FRONTEND_ADC
+        if (adc_overflow_count != reported_adc_overflows) {
+            ESP_LOGW(TAG, "ADC ring buffer overflow: %lu frame(s) dropped", (unsigned long)(adc_overflow_count - reported_adc_overflows));
+            reported_adc_overflows = adc_overflow_count;
+        }
+#endif
+#if CONFIG_MORSE_ADC_TIMER
+        if (sample_timer_missed != reported_timer_misses) {
+            ESP_LOGW(TAG, "Sample timer: %lu alarm(s) missed", (unsigned long)(sample_timer_missed - reported_timer_misses));
+            reported_timer_misses = sample_timer_missed;
+        }
+#endif
+#if CONFIG_MORSE_CAPTURE
+        if (capture_dropped != reported_capture_drops) {
+            ESP_LOGW(TAG, "Capture buffer full: %lu block(s) dropped", (unsigned long)(capture_dropped - reported_capture_drops));
+            reported_capture_drops = capture_dropped;
+        }
+#endif
+        unsigned queue_overflows = edge_queue_overflow_count(&edge_queue);
+        if (queue_overflows != reported_queue_overflows) {
+            ESP_LOGW(TAG, "Edge queue overflow: %u event(s) dropped", queue_overflows - reported_queue_overflows);
+            reported_queue_overflows = queue_overflows;
+        }
+    }
+}
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+/*---------------------------------------------------------------
+        Wake Preamble
+---------------------------------------------------------------*/
+// The first pulse after CONFIG_MORSE_SLEEP_IDLE_MS of darkness is the
+// transmitter's wake preamble whether or not the chip got to sleep, so both
+// ends agree on it without a handshake. The decoder never sees it; the gap
+// before the first real symbol is still a word gap from the last message.
+static bool skip_wake_preamble(rx_channel_t *channel, const edge_event_t *event)
+{
+    int64_t previous_edge_us = channel->last_edge_us;
+    channel->last_edge_us = event->time_us;
+
+    if (event->type == EDGE_EVENT_RISE) {
+        if (event->time_us - previous_edge_us < SLEEP_IDLE_US) {
+            return false;
+        }
+        int64_t wake_us = last_wake_us;
+        channel->preamble_start_us = event->time_us;
+        channel->preamble_resume_us = (wake_us >= 0 && wake_us > previous_edge_us) ? event->time_us - wake_us : -1;
+        return true;
+    }
+    if (channel->preamble_start_us < 0) {
+        return false;
+    }
+
+    int32_t seen_us = (int32_t)(event->time_us - channel->preamble_start_us);
+    channel->preamble_start_us = -1;
+#if CONFIG_MORSE_PERF_STATS
+    if (channel->preamble_resume_us >= 0 && seen_us < CONFIG_MORSE_WAKE_PREAMBLE_MS * 1000) {
+        perf_stage_add(&perf.wake_latency, perf_generation, (uint32_t)(CONFIG_MORSE_WAKE_PREAMBLE_MS * 1000 - seen_us));
+    }
+#endif
+    event_log_record_t record = {
+        .time_us = event->time_us,
+        .duration_us = seen_us,
+        .type = LOG_RECORD_WAKE,
+        .channel = channel->id,
+    };
+    event_log_write(&event_log, &record);
+    return true;
+}
+
+// Decoder task: nothing half-decoded that sleeping would hold back
+static bool decoders_quiet(void)
+{
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        const morse_decoder_t *decoder = &channels[c].decoder;
+        if (decoder->light_state || decoder->morse_index != 0 || decoder->output_length != 0) {
+            return false;
+        }
+#if CONFIG_MORSE_DATA_MODE
+        if (morse_data_active(&channels[c].data_rx)) {
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+// Dark for the idle time, counting from the last edge and the last wake-up
+static bool idle_long_enough(int64_t now_us, int64_t last_edge_us)
+{
+    return now_us - last_edge_us >= SLEEP_IDLE_US && now_us - last_wake_us >= SLEEP_IDLE_US;
+}
+#endif
+
+static void process_edge_event(const edge_event_t *event)
+{
+    rx_channel_t *channel = &channels[event->channel];
+    morse_decoder_t *decoder = &channel->decoder;
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+    if (event->type != EDGE_EVENT_TICK && skip_wake_preamble(channel, event)) {
+        return;
+    }
+#endif
+
+#if CONFIG_MORSE_DATA_MODE
+    // During a data burst the Morse decoder sees nothing; it picks up the
+    // silence after the burst as an ordinary gap
+    morse_data_t *data_rx = &channel->data_rx;
+    if (morse_data_active(data_rx)) {
+        bool consumed = (event->type == EDGE_EVENT_TICK)
+                        ? morse_data_tick(data_rx, event->time_us)
+                        : morse_data_edge(data_rx, event->type == EDGE_EVENT_RISE, event->time_us);
+        if (consumed) {
+            return;
+        }
+    }
+#endif
+
+    switch (event->type) {
+    case EDGE_EVENT_RISE:
+        morse_decoder_rise(decoder, event->time_us);
+        break;
+    case EDGE_EVENT_FALL:
+        morse_decoder_fall(decoder, event->time_us);
+        break;
+    default:
+        morse_decoder_tick(decoder, event->time_us);
+        break;
+    }
+}
+
+// Cycles include any time the sampler preempts the decoder, so max is an upper bound
+static void decode_event(const edge_event_t *event)
+{
+#if CONFIG_MORSE_PERF_STATS
+    uint32_t start = esp_cpu_get_cycle_count();
+    process_edge_event(event);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    perf_stage_add((event->type == EDGE_EVENT_TICK) ? &perf.decode_tick : &perf.decode_edge, perf_generation, cycles);
+#else
+    process_edge_event(event);
+#endif
+}
+
+/*---------------------------------------------------------------
+        Decoder Task (consumer) - decoding only
+---------------------------------------------------------------*/
+static void decoder_task(void *arg)
+{
+    while (1) {
+        edge_event_t event;
+#if CONFIG_MORSE_FRONTEND_GPIO
+        // The ISR only reports edges, so idle timeouts are driven from here on
+        // the same esp_timer clock the edges are stamped with
+#if CONFIG_MORSE_PERF_STATS
+        int64_t wait_start_us = esp_timer_get_time();
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EDGE_CAPTURE_TICK_MS)) == 0) {
+            int64_t error_us = esp_timer_get_time() - wait_start_us - EDGE_CAPTURE_TICK_MS * 1000;
+            perf_stage_add(&perf.tick_jitter, perf_generation, (uint32_t)(error_us < 0 ? -error_us : error_us));
+        }
+#else
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EDGE_CAPTURE_TICK_MS));
+#endif
+        while (edge_queue_pop(&edge_queue, &event)) {
+#if CONFIG_MORSE_PERF_STATS
+            // GPIO edges are stamped on the same clock in the ISR
+            perf_stage_add(&perf.edge_latency, perf_generation, (uint32_t)(esp_timer_get_time() - event.time_us));
+#endif
+            decode_event(&event);
+        }
+        event.time_us = esp_timer_get_time();
+        event.type = EDGE_EVENT_TICK;
+        event.channel = 0;
+        decode_event(&event);
+#if CONFIG_MORSE_LIGHT_SLEEP
+        if (!edge_last_level && decoders_quiet() && idle_long_enough(event.time_us, channels[0].last_edge_us)) {
+            edge_light_sleep();
+        }
+#endif
+#else
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (edge_queue_pop(&edge_queue, &event)) {
+            decode_event(&event);
+        }
+#if CONFIG_MORSE_LIGHT_SLEEP
+        decoders_idle = decoders_quiet();
+#endif
+#endif
+    }
+}
+
+#if CONFIG_MORSE_FRONTEND_ADC
+#if !CONFIG_MORSE_ADC_TIMER
+/*---------------------------------------------------------------
+        Continuous ADC Callbacks
+---------------------------------------------------------------*/
+static bool IRAM_ATTR adc_pool_overflow_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    // Runs in ISR context: just count, the log task reports it
+    adc_overflow_count++;
+    return false;
+}
+#endif
+
+/*---------------------------------------------------------------
+        Sampling Task (producer) - only slices and timestamps
+---------------------------------------------------------------*/
+static inline int64_t sample_time_us(int64_t sample)
+{
+    return (sample * 1000000) / sample_freq_hz;
+}
+
+// Receiver channel for one conversion result, or NULL if it isn't ours
+static inline rx_channel_t *sample_channel(const adc_digi_output_data_t *p)
+{
+    unsigned adc_channel = ADC_GET_CHANNEL(p);
+    return (adc_channel < SOC_ADC_MAX_CHANNEL_NUM) ? adc_channel_map[adc_channel] : NULL;
+}
+
+#if CONFIG_MORSE_PERF_STATS
+// Time the controller takes to fill one DMA frame (all channels)
+static uint32_t frame_period(void)
+{
+    return (uint32_t)(((uint64_t)ADC_FRAME_SAMPLES * 1000000) / ((uint64_t)sample_freq_hz * RX_CHANNELS));
+}
+#endif
+
+#if CONFIG_MORSE_ADC_TIMER
+static bool IRAM_ATTR sample_alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sampling_task_handle, &task_woken);
+    return task_woken == pdTRUE;
+}
+
+// Wait for the timer and pack one-shot readings into adc_frame in the DMA
+// driver's format, so calibration and slicing are the same for both drivers.
+// A reading that comes in after missed alarms fills their slots too, so the
+// sample clock keeps counting real sample periods.
+static uint32_t read_frame(adc_source_t adc_handle)
+{
+    static int raw[RX_CHANNELS];
+    static uint32_t pending = 0;                // Slots still owed to the last reading
+    static uint64_t last_latency_us = 0;
+    uint32_t bytes = 0;
+
+    while (bytes + RX_CHANNELS * SOC_ADC_DIGI_RESULT_BYTES <= ADC_FRAME_BYTES) {
+        if (pending == 0) {
+            uint32_t alarms = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ADC_READ_TIMEOUT_MS));
+            if (alarms == 0) {
+                break;
+            }
+
+            // The counter reloads at every alarm, so it reads the wake-up latency directly
+            uint64_t latency_us = 0;
+            gptimer_get_raw_count(sample_timer, &latency_us);
+            for (int c = 0; c < RX_CHANNELS; c++) {
+                ESP_ERROR_CHECK(adc_oneshot_read(adc_handle, channels[c].adc_channel, &raw[c]));
+            }
+            perf_stage_add(&sample_latency, perf_generation, (uint32_t)latency_us);
+            if (alarms == 1) {
+                // This period minus the last one is the change in latency
+                uint32_t jitter_us = (uint32_t)((latency_us > last_latency_us) ? latency_us - last_latency_us
+                                                                               : last_latency_us - latency_us);
+                perf_stage_add(&sample_jitter, perf_generation, jitter_us);
+            } else {
+                sample_timer_missed += alarms - 1;
+            }
+            last_latency_us = latency_us;
+            pending = alarms;
+        }
+
+        for (int c = 0; c < RX_CHANNELS; c++) {
+            ADC_SET_RESULT((adc_digi_output_data_t *)&adc_frame[bytes], channels[c].adc_channel, raw[c]);
+            bytes += SOC_ADC_DIGI_RESULT_BYTES;
+        }
+        pending--;
+    }
+    return bytes;
+}
+#else
+static uint32_t read_frame(adc_source_t adc_handle)
+{
+    uint32_t bytes_read = 0;
+    esp_err_t ret = adc_continuous_read(adc_handle, adc_frame, ADC_FRAME_BYTES, &bytes_read, ADC_READ_TIMEOUT_MS);
+    if (ret == ESP_ERR_TIMEOUT) {
+        return 0;  // No frame yet; the blocking read already yielded to the scheduler
+    }
+    ESP_ERROR_CHECK(ret);
+    return bytes_read;
+}
+#endif
+
+// Glitch filter length in samples at the current rate
+static uint32_t glitch_samples(void)
+{
+    uint32_t samples = (uint32_t)(((uint64_t)CONFIG_MORSE_GLITCH_US * sample_freq_hz) / 1000000);
+    return samples ? samples : 1;
+}
+
+#if CONFIG_MORSE_DSP
+// Matched filter window: half the glitch floor, since anything the filter would smear is rejected anyway
+static uint32_t dsp_window_samples(void)
+{
+    return (uint32_t)(((uint64_t)rx_profile->glitch_us * sample_freq_hz) / 2000000);
+}
+#endif
+
+// Raw ADC value -> slicer input
+static inline int32_t condition_sample(rx_channel_t *channel, int32_t raw)
+{
+#if CONFIG_MORSE_DSP
+    if (!channel->dsp_primed) {
+        // Primed with the first real sample: the ambient level during calibration, or the
+        // first decoded sample with a fixed threshold
+        morse_dsp_init(&channel->dsp, dsp_window_samples(), raw);
+        channel->dsp_primed = true;
+    }
+    return morse_dsp_filter(&channel->dsp, raw);
+#else
+    return raw;
+#endif
+}
+
+// Samples between a light change and the slicer seeing it
+static inline uint32_t condition_delay(const rx_channel_t *channel)
+{
+#if CONFIG_MORSE_DSP
+    return morse_dsp_delay(&channel->dsp);
+#else
+    return 0;
+#endif
+}
+
+#if CONFIG_MORSE_CAPTURE
+// Raw sample into the channel's capture block; a full block goes to the capture task whole or not at all
+static inline void capture_sample(rx_channel_t *channel, int32_t raw)
+{
+    static uint8_t block[MORSE_CAPTURE_BLOCK_MAX];
+
+    if (morse_capture_add(&channel->capture, raw)) {
+        size_t length = morse_capture_pack(&channel->capture, block);
+        if (xMessageBufferSend(capture_buffer, block, length, 0) == 0) {
+            morse_capture_drop(&channel->capture);
+            capture_dropped++;
+        }
+    }
+}
+#endif
+
+#if CONFIG_MORSE_ADAPTIVE_THRESHOLD
+// Measure the ambient level of every channel with the LEDs off before decoding starts
+static void calibrate_slicers(adc_source_t adc_handle)
+{
+    morse_slicer_cal_t cal[RX_CHANNELS];
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        morse_slicer_cal_reset(&cal[c]);
+    }
+    uint32_t target = (uint32_t)(((uint64_t)CONFIG_MORSE_CALIBRATION_MS * sample_freq_hz) / 1000);
+
+    ESP_LOGI(TAG, "Calibrating ambient light for %d ms - keep the LED off...", CONFIG_MORSE_CALIBRATION_MS);
+    bool done = false;
+    while (!done) {
+        uint32_t bytes_read = read_frame(adc_handle);
+        for (uint32_t i = 0; i < bytes_read; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *p = (adc_digi_output_data_t *)&adc_frame[i];
+            rx_channel_t *channel = sample_channel(p);
+            if (channel != NULL) {
+#if CONFIG_MORSE_CAPTURE
+                capture_sample(channel, (int32_t)ADC_GET_DATA(p));
+#endif
+                morse_slicer_cal_add(&cal[channel->id], condition_sample(channel, (int32_t)ADC_GET_DATA(p)));
+            }
+        }
+        done = true;
+        for (int c = 0; c < RX_CHANNELS; c++) {
+            done = done && cal[c].count >= target;
+        }
+    }
+
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        rx_channel_t *channel = &channels[c];
+        morse_slicer_init(&channel->slicer, &cal[c], CONFIG_MORSE_MIN_SWING, glitch_samples(),
+                          (uint32_t)(((uint64_t)SLICER_MAX_ON_MS * sample_freq_hz) / 1000));
+        ESP_LOGI(TAG, "%sAmbient %ld..%ld over %lu samples", channel_tag(channel->id),
+                 (long)cal[c].min, (long)cal[c].max, (unsigned long)cal[c].count);
+        log_light_levels(channel, "Calibrated");
+    }
+}
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+static int64_t sampler_last_edge_us = 0;        // Sample clock of the last edge on any channel
+
+static bool slicers_dark(void)
+{
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        if (channels[c].slicer.state) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stop the converter (its PM lock goes with it), sleep, and resume with the
+// sample clocks moved on by the time asleep so gaps keep their real length.
+// Frames still in the driver ring from before the stop are dark samples.
+static void adc_light_sleep(adc_source_t adc_handle)
+{
+#if CONFIG_MORSE_ADC_TIMER
+    ESP_ERROR_CHECK(gptimer_stop(sample_timer));
+#else
+    ESP_ERROR_CHECK(adc_continuous_stop(adc_handle));
+#endif
+
+    int64_t asleep_us = light_sleep_until_light();
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        channels[c].sample_count += (asleep_us * sample_freq_hz) / 1000000;
+    }
+    last_wake_us = sample_time_us(channels[0].sample_count);
+
+#if CONFIG_MORSE_ADC_TIMER
+    ulTaskNotifyTake(pdTRUE, 0);  // Alarms from before the stop
+    ESP_ERROR_CHECK(gptimer_set_raw_count(sample_timer, 0));
+    ESP_ERROR_CHECK(gptimer_start(sample_timer));
+#else
+    ESP_ERROR_CHECK(adc_continuous_start(adc_handle));
+#endif
+}
+#endif
+
+static void sampling_task(void *arg)
+{
+    adc_source_t adc_handle = (adc_source_t)arg;
+
+#if CONFIG_MORSE_ADC_TIMER
+    sampling_task_handle = xTaskGetCurrentTaskHandle();
+    ESP_ERROR_CHECK(gptimer_start(sample_timer));
+#else
+    ESP_ERROR_CHECK(adc_continuous_start(adc_handle));
+#endif
+
+#if CONFIG_MORSE_ADAPTIVE_THRESHOLD
+    calibrate_slicers(adc_handle);
+#else
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        morse_slicer_init_fixed(&channels[c].slicer, CONFIG_MORSE_LIGHT_THRESHOLD, glitch_samples());
+    }
+#endif
+    ESP_LOGI(TAG, "Glitch filter: %lu sample(s)", (unsigned long)channels[0].slicer.glitch_samples);
+#if CONFIG_MORSE_DSP
+    ESP_LOGI(TAG, "Matched filter: %lu taps, ML timing thresholds", (unsigned long)morse_dsp_taps(dsp_window_samples()));
+#endif
+
+    // Decoding starts on a clean sample clock once calibration is done
+    ESP_LOGI(TAG, "Starting Morse code detection...");
+    ESP_LOGI(TAG, "Send Morse code from Pi now!");
+
+#if CONFIG_MORSE_PERF_STATS
+    const uint32_t frame_period_us = frame_period();
+    int64_t last_frame_us = 0;
+#endif
+    while (1) {
+        uint32_t bytes_read = read_frame(adc_handle);
+        if (bytes_read == 0) {
+            continue;
+        }
+#if CONFIG_MORSE_PERF_STATS
+        uint32_t start = esp_cpu_get_cycle_count();
+        int64_t now_us = esp_timer_get_time();
+        if (last_frame_us != 0) {
+            uint32_t interval_us = (uint32_t)(now_us - last_frame_us);
+            perf_stage_add(&perf.frame_interval, perf_generation, interval_us);
+            perf_stage_add(&perf.frame_jitter, perf_generation,
+                           (interval_us > frame_period_us) ? interval_us - frame_period_us
+                                                           : frame_period_us - interval_us);
+            if (interval_us < frame_period_us / 2) {
+                perf.late_frames++;  // Returned at once: it was sitting in the ring behind the last one
+            }
+        }
+        last_frame_us = now_us;
+#endif
+
+        edge_event_t event;
+        for (uint32_t i = 0; i < bytes_read; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *p = (adc_digi_output_data_t *)&adc_frame[i];
+            rx_channel_t *channel = sample_channel(p);
+            if (channel == NULL) {
+                continue;
+            }
+#if CONFIG_MORSE_CAPTURE
+            capture_sample(channel, (int32_t)ADC_GET_DATA(p));
+#endif
+
+            uint32_t edge_delay;
+            if (morse_slicer_feed(&channel->slicer, condition_sample(channel, (int32_t)ADC_GET_DATA(p)), &edge_delay)) {
+                // Timestamp from the sample clock at the start of the confirming run
+                event.time_us = sample_time_us(channel->sample_count - edge_delay - condition_delay(channel));
+                event.type = channel->slicer.state ? EDGE_EVENT_RISE : EDGE_EVENT_FALL;
+                event.channel = channel->id;
+                edge_queue_push(&edge_queue, &event);
+#if CONFIG_MORSE_LIGHT_SLEEP
+                sampler_last_edge_us = event.time_us;
+#endif
+            }
+            channel->sample_count++;
+        }
+
+        // One tick per frame and channel keeps the decoders' idle timeouts moving
+        for (int c = 0; c < RX_CHANNELS; c++) {
+            event.time_us = sample_time_us(channels[c].sample_count);
+            event.type = EDGE_EVENT_TICK;
+            event.channel = (uint8_t)c;
+            edge_queue_push(&edge_queue, &event);
+        }
+
+        xTaskNotifyGive(decoder_task_handle);
+#if CONFIG_MORSE_PERF_STATS
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        perf_stage_add(&perf.frame, perf_generation, cycles);
+        if (cycles > frame_period_us * CPU_CYCLES_PER_US) {
+            perf.overruns++;
+        }
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+        // decoders_idle lags by up to a frame; the sampler's own edge time covers that
+        if (decoders_idle && slicers_dark() &&
+            idle_long_enough(sample_time_us(channels[0].sample_count), sampler_last_edge_us)) {
+            adc_light_sleep(adc_handle);
+#if CONFIG_MORSE_PERF_STATS
+            last_frame_us = 0;  // The sleep is not a frame interval
+#endif
+        }
+#endif
+    }
+}
+
+#if CONFIG_MORSE_ADC_TIMER
+/*---------------------------------------------------------------
+        Timer-Driven ADC Setup
+---------------------------------------------------------------*/
+// freq_hz is per channel; every alarm converts each channel once
+static adc_source_t adc_frontend_init(uint32_t channel_freq_hz)
+{
+    uint32_t freq_hz = channel_freq_hz;
+    if (freq_hz * RX_CHANNELS > SAMPLE_TIMER_MAX_HZ) {
+        freq_hz = SAMPLE_TIMER_MAX_HZ / RX_CHANNELS;
+        ESP_LOGW(TAG, "Sample rate limited to %lu Hz per channel for timer-driven sampling", (unsigned long)freq_hz);
+    }
+    sample_period_us = (SAMPLE_TIMER_RESOLUTION_HZ + freq_hz - 1) / freq_hz;
+    sample_freq_hz = SAMPLE_TIMER_RESOLUTION_HZ / sample_period_us;
+
+    //-------------ADC1 One-Shot Init---------------//
+    adc_oneshot_unit_handle_t adc_handle = NULL;
+    adc_oneshot_unit_init_cfg_t unit_config = {
+        .unit_id = ADC_UNIT_1,
+    };
+    ESP_ERROR_CHECK(adc_oneshot_new_unit(&unit_config, &adc_handle));
+
+    adc_oneshot_chan_cfg_t channel_config = {
+        .atten = EXAMPLE_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_handle, channels[c].adc_channel, &channel_config));
+    }
+
+    //-------------Sample Timer Init---------------//
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = SAMPLE_TIMER_RESOLUTION_HZ,
+    };
+    ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &sample_timer));
+
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = sample_alarm_cb,
+    };
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(sample_timer, &cbs, NULL));
+
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = sample_period_us,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(sample_timer, &alarm_config));
+    ESP_ERROR_CHECK(gptimer_enable(sample_timer));
+
+    //-------------ADC1 Calibration Init---------------//
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        channels[c].calibrated = example_adc_calibration_init(ADC_UNIT_1, channels[c].adc_channel, EXAMPLE_ADC_ATTEN,
+                                                              &channels[c].cali_handle);
+    }
+
+    return adc_handle;
+}
+#else
+/*---------------------------------------------------------------
+        Continuous ADC Setup
+---------------------------------------------------------------*/
+// freq_hz is per channel; the controller runs RX_CHANNELS times as fast
+static adc_source_t adc_frontend_init(uint32_t channel_freq_hz)
+{
+    uint32_t freq_hz = channel_freq_hz * RX_CHANNELS;
+    if (freq_hz < ADC_MIN_SAMPLE_FREQ_HZ || freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW) {
+        freq_hz = (ADC_MIN_SAMPLE_FREQ_HZ > SOC_ADC_SAMPLE_FREQ_THRES_LOW) ? ADC_MIN_SAMPLE_FREQ_HZ : SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+        ESP_LOGW(TAG, "Sample rate raised to %lu Hz", (unsigned long)freq_hz);
+    } else if (freq_hz > ADC_MAX_SAMPLE_FREQ_HZ || freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        freq_hz = (ADC_MAX_SAMPLE_FREQ_HZ < SOC_ADC_SAMPLE_FREQ_THRES_HIGH) ? ADC_MAX_SAMPLE_FREQ_HZ : SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+        ESP_LOGW(TAG, "Sample rate limited to %lu Hz", (unsigned long)freq_hz);
+    }
+    sample_freq_hz = freq_hz / RX_CHANNELS;
+
+    //-------------ADC1 Continuous Init---------------//
+    adc_continuous_handle_t adc_handle = NULL;
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_FRAME_BYTES * ADC_RING_FRAMES,
+        .conv_frame_size = ADC_FRAME_BYTES,
+    };
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_config, &adc_handle));
+
+    //-------------ADC1 Continuous Config---------------//
+    // One pattern entry per photodiode: the controller converts them in turn
+    adc_digi_pattern_config_t adc_pattern[SOC_ADC_PATT_LEN_MAX] = {0};
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        adc_pattern[c].atten = EXAMPLE_ADC_ATTEN;
+        adc_pattern[c].channel = channels[c].adc_channel & 0x7;
+        adc_pattern[c].unit = ADC_UNIT_1;
+        adc_pattern[c].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_continuous_config_t dig_config = {
+        .pattern_num = RX_CHANNELS,
+        .adc_pattern = adc_pattern,
+        .sample_freq_hz = sample_freq_hz,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_OUTPUT_TYPE,
+    };
+    ESP_ERROR_CHECK(adc_continuous_config(adc_handle, &dig_config));
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_pool_ovf = adc_pool_overflow_cb,
+    };
+    ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc_handle, &cbs, NULL));
+
+    //-------------ADC1 Calibration Init---------------//
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        channels[c].calibrated = example_adc_calibration_init(ADC_UNIT_1, channels[c].adc_channel, EXAMPLE_ADC_ATTEN,
+                                                              &channels[c].cali_handle);
+    }
+
+    return adc_handle;
+}
+#endif
+#endif
+
+#if CONFIG_MORSE_FRONTEND_GPIO
+/*---------------------------------------------------------------
+        GPIO Edge Capture (producer)
+---------------------------------------------------------------*/
+// A comparator drives CONFIG_MORSE_EDGE_GPIO high while the LED is on. Edges
+// are timestamped with esp_timer_get_time() in the interrupt (microsecond
+// resolution, no per-sample CPU cost) and the ADC is not used.
+static void IRAM_ATTR edge_capture_isr(void *arg)
+{
+    int level = gpio_get_level(CONFIG_MORSE_EDGE_GPIO);
+
+    // Comparator chatter can fire twice at the same level; forward real transitions only
+    if (level == edge_last_level) {
+        return;
+    }
+    edge_last_level = level;
+
+    edge_event_t event = {
+        .time_us = esp_timer_get_time(),
+        .type = level ? EDGE_EVENT_RISE : EDGE_EVENT_FALL,
+    };
+    edge_queue_push(&edge_queue, &event);
+
+    BaseType_t task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(decoder_task_handle, &task_woken);
+    portYIELD_FROM_ISR(task_woken);
+}
+
+static void edge_capture_init(void)
+{
+    gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << CONFIG_MORSE_EDGE_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_config));
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(CONFIG_MORSE_EDGE_GPIO, edge_capture_isr, NULL));
+}
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+// Decoder task. The wake-up uses the pin's interrupt type, so edge capture
+// is off while asleep, and the rise that woke the chip is reported here. If
+// the light is already off again the preamble was shorter than the wake-up:
+// the fall is lost and the first real pulse is skipped in its place.
+static void edge_light_sleep(void)
+{
+    ESP_ERROR_CHECK(gpio_intr_disable(CONFIG_MORSE_EDGE_GPIO));
+    light_sleep_until_light();
+    ESP_ERROR_CHECK(gpio_set_intr_type(CONFIG_MORSE_EDGE_GPIO, GPIO_INTR_ANYEDGE));
+
+    int64_t now_us = esp_timer_get_time();
+    last_wake_us = now_us;
+    if (gpio_get_level(CONFIG_MORSE_EDGE_GPIO)) {
+        // The ISR is off, so this task is the only producer
+        edge_event_t event = {
+            .time_us = now_us,
+            .type = EDGE_EVENT_RISE,
+        };
+        edge_queue_push(&edge_queue, &event);
+        edge_last_level = 1;
+        xTaskNotifyGive(decoder_task_handle);
+    }
+    ESP_ERROR_CHECK(gpio_intr_enable(CONFIG_MORSE_EDGE_GPIO));
+}
+#endif
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+/*---------------------------------------------------------------
+        Light Sleep
+---------------------------------------------------------------*/
+static void light_sleep_init(void)
+{
+#if CONFIG_MORSE_FRONTEND_ADC
+    gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << WAKE_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_config));
+#endif
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#if CONFIG_MORSE_PERF_STATS && CONFIG_ESP_CONSOLE_UART
+    // Typing at the stats console wakes the chip too
+    ESP_ERROR_CHECK(uart_set_wakeup_threshold(CONFIG_ESP_CONSOLE_UART_NUM, UART_WAKE_THRESHOLD));
+    ESP_ERROR_CHECK(esp_sleep_enable_uart_wakeup(CONFIG_ESP_CONSOLE_UART_NUM));
+#endif
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    ESP_LOGW(TAG, "Light sleep: the USB-Serial-JTAG console disconnects while the chip sleeps");
+#endif
+    ESP_LOGI(TAG, "Light sleep after %d ms idle, wake on GPIO%d; send a wake preamble of at least the wake-up time",
+             CONFIG_MORSE_SLEEP_IDLE_MS, WAKE_GPIO);
+}
+
+// Called by the producer with sampling stopped. Gives the lower-priority
+// tasks time to finish printing, then sleeps until the wake GPIO sees light
+// (or a keystroke arrives). Returns the time asleep.
+static int64_t light_sleep_until_light(void)
+{
+    for (int waited = 0; waited < SLEEP_DRAIN_TIMEOUT_MS; waited += SLEEP_DRAIN_POLL_MS) {
+        bool drained = edge_queue_empty(&edge_queue) && event_log_empty(&event_log);
+#if CONFIG_MORSE_OUTPUT_STREAM
+        drained = drained && xStreamBufferIsEmpty(output_stream);
+#endif
+        // One more poll after the rings empty lets the last record finish printing
+        vTaskDelay(pdMS_TO_TICKS(SLEEP_DRAIN_POLL_MS));
+        if (drained) {
+            break;
+        }
+    }
+#if CONFIG_ESP_CONSOLE_UART
+    uart_wait_tx_idle_polling(CONFIG_ESP_CONSOLE_UART_NUM);
+#endif
+
+    ESP_ERROR_CHECK(gpio_wakeup_enable(WAKE_GPIO, GPIO_INTR_HIGH_LEVEL));
+    int64_t start_us = esp_timer_get_time();
+    esp_light_sleep_start();
+    int64_t asleep_us = esp_timer_get_time() - start_us;
+    ESP_ERROR_CHECK(gpio_wakeup_disable(WAKE_GPIO));
+
+    sleep_stats.count++;
+    sleep_stats.asleep_us += asleep_us;
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UART) {
+        sleep_stats.console_wakes++;
+    }
+    return asleep_us;
+}
+#endif
+
+#if CONFIG_MORSE_PERF_STATS
+/*---------------------------------------------------------------
+        Performance Report ("stats" console command)
+---------------------------------------------------------------*/
+static const struct {
+    const char *name;
+    perf_stage_t *stage;
+    bool cycles;                                // CPU cycles, else microseconds
+} perf_stages[] = {
+#if CONFIG_MORSE_FRONTEND_ADC
+    {"adc frame", &perf.frame, true},
+    {"frame interval", &perf.frame_interval, false},
+    {"frame jitter", &perf.frame_jitter, false},
+#if CONFIG_MORSE_ADC_TIMER
+    {"sample jitter", &sample_jitter, false},
+    {"sample latency", &sample_latency, false},
+#endif
+#else
+    {"edge latency", &perf.edge_latency, false},
+    {"tick jitter", &perf.tick_jitter, false},
+#endif
+    {"decode edge", &perf.decode_edge, true},
+    {"decode tick", &perf.decode_tick, true},
+    {"output", &perf.output, true},
+    {"log", &perf.log, true},
+#if CONFIG_MORSE_LIGHT_SLEEP
+    {"wake latency", &perf.wake_latency, false},
+#endif
+};
+
+// Only the writer tasks touch their stages and counts: the stages clear
+// themselves at their next sample and the counts are read against a base
+static void stats_reset(void)
+{
+    perf_generation++;
+#if CONFIG_MORSE_FRONTEND_ADC
+    perf.overruns_base = perf.overruns;
+    perf.late_frames_base = perf.late_frames;
+    perf.adc_overflow_base = adc_overflow_count;
+#endif
+#if CONFIG_MORSE_ADC_TIMER
+    perf.timer_missed_base = sample_timer_missed;
+#endif
+    perf.queue_overflow_base = edge_queue_overflow_count(&edge_queue);
+    perf.log_drop_base = event_log_dropped_count(&event_log);
+    perf.since_us = esp_timer_get_time();
+}
+
+static void print_stage(const char *name, const perf_stage_t *live, bool cycles)
+{
+    perf_stage_t stage = perf_stage_read(live, perf_generation);
+    const char *unit = cycles ? "cyc" : "us";
+
+    if (stage.count == 0) {
+        printf("%-15s no samples\n", name);
+        return;
+    }
+    uint32_t average = (uint32_t)(stage.total / stage.count);
+    printf("%-15s %9lu  min %7lu  avg %7lu  max %8lu %s", name, (unsigned long)stage.count,
+           (unsigned long)stage.min, (unsigned long)average, (unsigned long)stage.max, unit);
+    if (cycles) {
+        printf("  (avg %lu.%02lu us)", (unsigned long)(average / CPU_CYCLES_PER_US),
+               (unsigned long)(average % CPU_CYCLES_PER_US * 100 / CPU_CYCLES_PER_US));
+    }
+    printf("\n   ");
+    // Power-of-two histogram, upper bounds only
+    for (unsigned b = 0; b < PERF_HIST_BUCKETS; b++) {
+        if (stage.hist[b] == 0) {
+            continue;
+        }
+        if (b == PERF_HIST_BUCKETS - 1) {
+            printf(" >=%lu:%lu", (unsigned long)perf_bucket_floor(b), (unsigned long)stage.hist[b]);
+        } else {
+            printf(" <%lu:%lu", (unsigned long)perf_bucket_floor(b + 1), (unsigned long)stage.hist[b]);
+        }
+    }
+    printf("\n");
+}
+
+static void stats_print(void)
+{
+    int64_t window_us = esp_timer_get_time() - perf.since_us;
+    printf("Perf counters over %lld.%03lld s (%d MHz CPU clock)\n", window_us / 1000000, window_us / 1000 % 1000,
+           CPU_CYCLES_PER_US);
+#if CONFIG_MORSE_FRONTEND_ADC
+    printf("ADC: %lu Hz x %d channel(s), %d samples per frame, frame period %lu us\n",
+           (unsigned long)sample_freq_hz, RX_CHANNELS, ADC_FRAME_SAMPLES, (unsigned long)frame_period());
+#if CONFIG_MORSE_ADC_TIMER
+    printf("Sample timer: %lu us period\n", (unsigned long)sample_period_us);
+    printf("Missed samples: %lu (timer alarms the sampling task was late for)\n",
+           (unsigned long)(sample_timer_missed - perf.timer_missed_base));
+#else
+    uint32_t dropped_frames = adc_overflow_count - perf.adc_overflow_base;
+    printf("Missed samples: %lu (%lu frame(s) dropped by the driver)\n",
+           (unsigned long)dropped_frames * ADC_FRAME_SAMPLES, (unsigned long)dropped_frames);
+#endif
+    uint32_t late_frames = perf.late_frames - perf.late_frames_base;
+    printf("Late samples:   %lu (%lu frame(s) read from a backlog)\n",
+           (unsigned long)late_frames * ADC_FRAME_SAMPLES, (unsigned long)late_frames);
+    printf("Loop overruns:  %lu frame(s) took longer than the frame period\n",
+           (unsigned long)(perf.overruns - perf.overruns_base));
+#endif
+    printf("Edge queue overflows: %u, event log drops: %u\n",
+           edge_queue_overflow_count(&edge_queue) - perf.queue_overflow_base,
+           event_log_dropped_count(&event_log) - perf.log_drop_base);
+#if CONFIG_MORSE_LIGHT_SLEEP
+    printf("Light sleep: %lu wake-up(s), %lld ms asleep since boot\n", (unsigned long)sleep_stats.count,
+           sleep_stats.asleep_us / 1000);
+#endif
+    for (size_t i = 0; i < sizeof(perf_stages) / sizeof(perf_stages[0]); i++) {
+        print_stage(perf_stages[i].name, perf_stages[i].stage, perf_stages[i].cycles);
+    }
+}
+
+static int stats_command(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        stats_reset();
+        printf("Perf counters reset\n");
+        return 0;
+    }
+    if (argc != 1) {
+        printf("Usage: stats [reset]\n");
+        return 1;
+    }
+    stats_print();
+    return 0;
+}
+
+// REPL on the console (UART or USB-Serial-JTAG), at log task priority
+static void stats_console_start(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = STATS_PROMPT;
+    repl_config.task_priority = LOG_TASK_PRIORITY;
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl));
+#else
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &repl));
+#endif
+
+    const esp_console_cmd_t command = {
+        .command = "stats",
+        .help = "Print hot-path timing, jitter histograms and missed/late samples; 'stats reset' clears them",
+        .func = stats_command,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&command));
+    ESP_ERROR_CHECK(esp_console_start_repl(repl));
+}
+#endif
+
+/*---------------------------------------------------------------
+        Receiver Start
+---------------------------------------------------------------*/
+// Switch a decoder to the timing tolerance model (no-op with fixed or ML thresholds)
+static void set_timing_tolerance(morse_decoder_t *decoder, int32_t default_jitter_us)
+{
+#if CONFIG_MORSE_TIMING_TOLERANCE_PCT > 0
+    int32_t jitter_us = (CONFIG_MORSE_TIMING_JITTER_US > 0) ? CONFIG_MORSE_TIMING_JITTER_US : default_jitter_us;
+    morse_speed_set_tolerance(&decoder->speed, CONFIG_MORSE_TIMING_TOLERANCE_PCT, jitter_us);
+    ESP_LOGI(TAG, "Timing tolerance %d%% + %ld us jitter: dash at %ld.%02ld units, word gap at %ld.%02ld units",
+             CONFIG_MORSE_TIMING_TOLERANCE_PCT, (long)jitter_us,
+             (long)(decoder->speed.dash_q8 / 256), (long)((decoder->speed.dash_q8 % 256) * 100 / 256),
+             (long)(decoder->speed.word_q8 / 256), (long)((decoder->speed.word_q8 % 256) * 100 / 256));
+#else
+    (void)decoder;
+    (void)default_jitter_us;
+#endif
+}
+void morse_rx_start(const morse_profile_t *profile)
+{
+    rx_profile = profile;
+
+    ESP_LOGI(TAG, "Morse Code Receiver Ready - %s profile (%ld.%02ld ms dots%s)",
+             rx_profile->name, MS_FRACTION(rx_profile->dot_us), rx_profile->adaptive ? ", adaptive" : "");
+    edge_queue_init(&edge_queue);
+    event_log_init(&event_log);
+#if CONFIG_MORSE_FRONTEND_ADC
+    static const adc_channel_t adc_channels[] = PHOTODIODE_ADC_CHANNELS;
+    _Static_assert(RX_CHANNELS <= sizeof(adc_channels) / sizeof(adc_channels[0]), "More channels than photodiode inputs");
+#endif
+#if RX_CHANNELS > 1
+    morse_lanes_init(&lanes, RX_CHANNELS, log_stripe, NULL);
+#endif
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        rx_channel_t *channel = &channels[c];
+        channel->id = (uint8_t)c;
+#if CONFIG_MORSE_FRONTEND_ADC
+        channel->adc_channel = adc_channels[c];
+        adc_channel_map[adc_channels[c]] = channel;
+#endif
+        morse_page_init(&channel->output_page, log_page, channel);
+        morse_frame_init(&channel->frame_parser, log_frame, channel);
+#if CONFIG_MORSE_FILE_TRANSFER
+        morse_transfer_init(&channel->transfer);
+#endif
+#if CONFIG_MORSE_DATA_MODE
+        morse_data_init(&channel->data_rx, log_data, channel);
+#endif
+#if CONFIG_MORSE_LIGHT_SLEEP
+        channel->last_edge_us = -SLEEP_IDLE_US;  // A transmitter starting up sends the preamble too
+        channel->preamble_start_us = -1;
+        channel->preamble_resume_us = -1;
+#endif
+    }
+
+#if CONFIG_MORSE_FRONTEND_GPIO
+    ESP_LOGI(TAG, "Waiting for comparator edges on GPIO%d...", CONFIG_MORSE_EDGE_GPIO);
+
+    // Edge timestamps come from esp_timer
+    morse_decoder_init(&channels[0].decoder, rx_profile, esp_timer_get_time(), handle_decoder_event, &channels[0]);
+    set_timing_tolerance(&channels[0].decoder, GPIO_EDGE_JITTER_US);
+
+    ESP_LOGI(TAG, "Starting Morse code detection...");
+    ESP_LOGI(TAG, "Send Morse code from Pi now!");
+#else
+    adc_source_t adc_handle = adc_frontend_init(rx_profile->sample_freq_hz);
+
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        int io = -1;
+        adc_continuous_channel_to_io(ADC_UNIT_1, channels[c].adc_channel, &io);
+        ESP_LOGI(TAG, "%sWaiting for signal on GPIO%d...", channel_tag((uint8_t)c), io);
+    }
+#if CONFIG_MORSE_ADC_TIMER
+    ESP_LOGI(TAG, "Timer-driven ADC: %lu samples/sec per channel (%lu us gptimer period), %d samples per frame",
+             (unsigned long)sample_freq_hz, (unsigned long)sample_period_us, ADC_FRAME_SAMPLES);
+#else
+    ESP_LOGI(TAG, "Continuous ADC: %lu samples/sec per channel, %d samples per frame", (unsigned long)sample_freq_hz, ADC_FRAME_SAMPLES);
+#endif
+
+    // Sample clocks start at zero once the sampler has calibrated
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        morse_decoder_init(&channels[c].decoder, rx_profile, 0, handle_decoder_event, &channels[c]);
+#if CONFIG_MORSE_DSP
+        morse_speed_use_ml_thresholds(&channels[c].decoder.speed);
+#endif
+        set_timing_tolerance(&channels[c].decoder, (int32_t)(1000000 / sample_freq_hz));    // Edges land on a sample
+    }
+#endif
+
+    // Console output runs below both so a slow UART never holds up decoding
+    xTaskCreate(log_task, "morse_log", LOG_TASK_STACK, NULL, LOG_TASK_PRIORITY, NULL);
+#if CONFIG_MORSE_OUTPUT_STREAM
+    output_stream = xStreamBufferCreate(OUTPUT_STREAM_BYTES, 1);
+    xTaskCreate(output_task, "morse_output", OUTPUT_TASK_STACK, NULL, OUTPUT_TASK_PRIORITY, NULL);
+#endif
+
+    // Decoder runs below the sampler so it never holds up sampling
+    xTaskCreate(decoder_task, "morse_decode", DECODER_TASK_STACK, NULL, DECODER_TASK_PRIORITY, &decoder_task_handle);
+
+#if CONFIG_MORSE_PERF_STATS
+    stats_reset();
+    stats_console_start();
+#endif
+
+#if CONFIG_MORSE_LIGHT_SLEEP
+    light_sleep_init();
+#endif
+#if CONFIG_MORSE_CAPTURE
+    // After the stats console, which sets its own line endings
+    for (int c = 0; c < RX_CHANNELS; c++) {
+        morse_capture_init(&channels[c].capture, (uint8_t)c, sample_freq_hz, CONFIG_MORSE_CAPTURE_DECIMATION);
+    }
+    capture_buffer = xMessageBufferCreate(CAPTURE_BUFFER_BYTES);
+    capture_console_lf();
+    ESP_LOGI(TAG, "Capture mode: %lu samples/sec per channel (decimation %d) to the console; record with "
+             "tools/morse_capture.py", (unsigned long)channels[0].capture.block.sample_freq_hz, CONFIG_MORSE_CAPTURE_DECIMATION);
+    xTaskCreate(capture_task, "morse_capture", CAPTURE_TASK_STACK, NULL, CAPTURE_TASK_PRIORITY, NULL);
+#endif
+#if CONFIG_MORSE_FRONTEND_GPIO
+    edge_capture_init();
+#else
+    xTaskCreate(sampling_task, "morse_sample", SAMPLING_TASK_STACK, adc_handle, SAMPLING_TASK_PRIORITY, NULL);
+#endif
+}
+
+#if CONFIG_MORSE_FRONTEND_ADC
+/*---------------------------------------------------------------
+        ADC Calibration
+---------------------------------------------------------------*/
+static bool example_adc_calibration_init(adc_unit_t unit, adc_channel_t channel, adc_atten_t atten, adc_cali_handle_t *out_handle)
+{
+    adc_cali_handle_t handle = NULL;
+    esp_err_t ret = ESP_FAIL;
+    bool calibrated = false;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    if (!calibrated) {
+        ESP_LOGI(TAG, "calibration scheme version is %s", "Curve Fitting");
+        adc_cali_curve_fitting_config_t cali_config = {
+            .unit_id = unit,
+            .chan = channel,
+            .atten = atten,
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+        };
+        ret = adc_cali_create_scheme_curve_fitting(&cali_config, &handle);
+        if (ret == ESP_OK) {
+            calibrated = true;
+        }
+    }
+#endif
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    if (!calibrated) {
+        ESP_LOGI(TAG, "calibration scheme version is %s", "Line Fitting");
+        adc_cali_line_fitting_config_t cali_config = {
+            .unit_id = unit,
+            .atten = atten,
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+        };
+        ret = adc_cali_create_scheme_line_fitting(&cali_config, &handle);
+        if (ret == ESP_OK) {
+            calibrated = true;
+        }
+    }
+#endif
+
+    *out_handle = handle;
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Calibration Success");
+    } else if (ret == ESP_ERR_NOT_SUPPORTED || !calibrated) {
+        ESP_LOGW(TAG, "eFuse not burnt, skip software calibration");
+    } else {
+        ESP_LOGE(TAG, "Invalid arg or no memory");
+    }
+
+    return calibrated;
+}
+#endif
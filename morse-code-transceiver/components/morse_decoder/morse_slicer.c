@@ -0,0 +1,130 @@
+/*
+ * Author: Noah Laforet
+ * Adaptive light slicer
+ *
+ * Envelopes: only the envelope of the current state is updated (the OFF level
+ * while OFF, the ON level while ON), each with a slow per-sample EWMA, so
+ * ambient drift is followed during idle time and LED brightness during pulses.
+ * The ON level is kept at least min_swing above the OFF level.
+ *
+ * Threshold: midpoint of the envelopes, with a hysteresis band of a quarter of
+ * the swing (never narrower than twice the calibrated noise).
+ *
+ * Stuck ON: if ambient light jumps above the threshold the slicer would sit ON
+ * forever. After max_on_samples the current level is taken as the new OFF
+ * level and the slicer drops back to OFF.
+ */
+
+#include "morse_slicer.h"
+
+#define ENVELOPE_SHIFT      8       // EWMA weight 1/256 per sample
+
+static void update_thresholds(morse_slicer_t *slicer)
+{
+    if (slicer->high_q4 < slicer->low_q4 + slicer->min_swing_q4) {
+        slicer->high_q4 = slicer->low_q4 + slicer->min_swing_q4;
+    }
+
+    int32_t swing = slicer->high_q4 - slicer->low_q4;
+    int32_t band = swing / 4;
+    if (band < 2 * slicer->noise_q4) {
+        band = 2 * slicer->noise_q4;
+    }
+    if (band > swing / 2) {
+        band = swing / 2;
+    }
+
+    int32_t mid = slicer->low_q4 + swing / 2;
+    slicer->on_threshold = (mid + band / 2) / 16;
+    slicer->off_threshold = (mid - band / 2) / 16;
+}
+
+void morse_slicer_cal_reset(morse_slicer_cal_t *cal)
+{
+    cal->sum = 0;
+    cal->count = 0;
+    cal->min = INT32_MAX;
+    cal->max = INT32_MIN;
+}
+
+void morse_slicer_cal_add(morse_slicer_cal_t *cal, int32_t raw)
+{
+    cal->sum += raw;
+    cal->count++;
+    if (raw < cal->min) {
+        cal->min = raw;
+    }
+    if (raw > cal->max) {
+        cal->max = raw;
+    }
+}
+
+void morse_slicer_init(morse_slicer_t *slicer, const morse_slicer_cal_t *cal, int32_t min_swing,
+                       uint32_t glitch_samples, uint32_t max_on_samples)
+{
+    int32_t mean = cal->count ? (int32_t)(cal->sum / cal->count) : 0;
+    int32_t noise = cal->count ? (cal->max - cal->min) / 2 : 0;
+
+    *slicer = (morse_slicer_t) {
+        .adaptive = true,
+        .low_q4 = mean * 16,
+        .high_q4 = (mean + min_swing) * 16,
+        .min_swing_q4 = min_swing * 16,
+        .noise_q4 = noise * 16,
+        .glitch_samples = glitch_samples ? glitch_samples : 1,
+        .max_on_samples = max_on_samples,
+    };
+    update_thresholds(slicer);
+}
+
+void morse_slicer_init_fixed(morse_slicer_t *slicer, int32_t threshold, uint32_t glitch_samples)
+{
+    *slicer = (morse_slicer_t) {
+        .adaptive = false,
+        .on_threshold = threshold,
+        .off_threshold = threshold,
+        .glitch_samples = glitch_samples ? glitch_samples : 1,
+    };
+}
+
+bool morse_slicer_feed(morse_slicer_t *slicer, int32_t raw, uint32_t *edge_delay)
+{
+    slicer->run_samples++;
+
+    if (slicer->adaptive) {
+        int32_t *envelope = slicer->state ? &slicer->high_q4 : &slicer->low_q4;
+        *envelope += (raw * 16 - *envelope) >> ENVELOPE_SHIFT;
+        update_thresholds(slicer);
+
+        if (slicer->state && slicer->max_on_samples && slicer->run_samples > slicer->max_on_samples) {
+            // Ambient light, not the LED: re-baseline on the current level
+            slicer->low_q4 = slicer->high_q4;
+            update_thresholds(slicer);
+            slicer->state = false;
+            slicer->pending = 0;
+            slicer->run_samples = 0;
+            *edge_delay = 0;
+            return true;
+        }
+    }
+
+    bool past = slicer->state ? (raw < slicer->off_threshold) : (raw > slicer->on_threshold);
+    if (!past) {
+        if (slicer->pending) {
+            slicer->rejected_glitches++;
+        }
+        slicer->pending = 0;
+        return false;
+    }
+
+    if (++slicer->pending < slicer->glitch_samples) {
+        return false;
+    }
+
+    // Backdate the edge to the first sample of the confirming run
+    *edge_delay = slicer->pending - 1;
+    slicer->state = !slicer->state;
+    slicer->pending = 0;
+    slicer->run_samples = *edge_delay;
+    return true;
+}
@@ -0,0 +1,230 @@
+/*
+ * Author: Noah Laforet
+ * Adaptive Morse speed tracking
+ *
+ * Every classified pulse or gap is scaled back to one unit (dash / 3, letter
+ * gap / 3) and folded into a running estimate of the dot. The estimate moves
+ * quickly towards shorter units and slowly towards longer ones: the dot is the
+ * shortest element on the channel, so this lets the receiver lock on from a
+ * far-too-slow starting guess within a few letters while staying steady once
+ * locked. Each update is clamped to half/double the current estimate so a
+ * single glitch cannot throw it off.
+ *
+ * The one thing the running estimate cannot see is a transmitter that slowed
+ * to a multiple of the current unit (every dot then looks like a dash). No
+ * legitimate pulse is longer than a dash, so a pulse of 5+ units re-anchors
+ * the estimate at a third of its length.
+ *
+ * With adaptive tracking off the initial dot is kept and only the thresholds
+ * derived from it are used.
+ *
+ * Thresholds sit halfway between the nominal durations:
+ *   dot (1) / dash (3)            -> 2 units
+ *   symbol (1) / letter (3) gap   -> 2 units
+ *   letter (3) / word (7) gap     -> 5 units
+ *
+ * Maximum-likelihood thresholds: timing error on an optical link scales with
+ * the element (jitter of the sender's clock, rise/fall smear on short dots),
+ * so durations spread roughly log-normally around 1, 3 and 7 units. Equal
+ * spread in log space puts the decision boundary at the geometric mean:
+ *   dot / dash, symbol / letter   -> sqrt(3)  = 1.73 units
+ *   letter / word                 -> sqrt(21) = 4.58 units
+ *
+ * Tolerance model: with a known error budget the boundaries can follow the
+ * speed. A duration of n units is off by a relative part (r * n units: the
+ * sender's clock) and an absolute part (j at each edge: sample period,
+ * glitch filter, slicer). That gives sigma(n) = sqrt((r n dot)^2 + 2 j^2).
+ * The boundary between n1 and n2 sits the same number of sigmas from both:
+ *   t = (n1 sigma(n2) + n2 sigma(n1)) / (sigma(n1) + sigma(n2))
+ * At slow speeds the relative part dominates and the boundary moves towards
+ * the shorter element (1.5 and 4.2 units). At sub-millisecond dots the
+ * sample period dominates and the boundary goes back to the midpoint.
+ *
+ * Durations and the estimate are integer microseconds throughout.
+ */
+
+#include "morse_speed.h"
+
+#define DOWN_SHIFT              1       // Move 1/2 of the way towards a shorter unit
+#define UP_SHIFT                3       // Move 1/8 of the way towards a longer unit
+#define UNITS_Q8(u)             ((int32_t)((u) * 256 + 0.5))
+
+/*---------------------------------------------------------------
+        Tolerance Model
+---------------------------------------------------------------*/
+static uint32_t isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// Standard deviation of an n-unit duration, in us
+static int64_t sigma_us(const morse_speed_t *speed, int32_t units)
+{
+    int64_t relative = (int64_t)speed->tolerance_q8 * units * speed->dot_us / 256;
+    int64_t jitter = speed->jitter_us;
+    return isqrt64((uint64_t)(relative * relative + 2 * jitter * jitter));
+}
+
+// Boundary between n1 and n2 units, equally many sigmas from both
+static int32_t boundary_q8(int32_t n1, int64_t sigma1, int32_t n2, int64_t sigma2)
+{
+    if (sigma1 + sigma2 == 0) {
+        return (n1 + n2) * 128;
+    }
+    return (int32_t)((256 * (n1 * sigma2 + n2 * sigma1)) / (sigma1 + sigma2));
+}
+
+static void update_thresholds(morse_speed_t *speed)
+{
+    if (speed->tolerance_q8 == 0) {
+        return;
+    }
+    int64_t sigma1 = sigma_us(speed, 1);
+    int64_t sigma3 = sigma_us(speed, 3);
+    int64_t sigma7 = sigma_us(speed, 7);
+    speed->dash_q8 = boundary_q8(1, sigma1, 3, sigma3);
+    speed->letter_q8 = speed->dash_q8;
+    speed->word_q8 = boundary_q8(3, sigma3, 7, sigma7);
+}
+
+/*---------------------------------------------------------------
+        Estimator
+---------------------------------------------------------------*/
+static void set_dot(morse_speed_t *speed, int64_t dot)
+{
+    if (dot < MORSE_SPEED_MIN_DOT_US) {
+        dot = MORSE_SPEED_MIN_DOT_US;
+    } else if (dot > MORSE_SPEED_MAX_DOT_US) {
+        dot = MORSE_SPEED_MAX_DOT_US;
+    }
+    speed->dot_us = (int32_t)dot;
+    update_thresholds(speed);
+}
+
+static void update_estimate(morse_speed_t *speed, int64_t unit_us)
+{
+    if (!speed->adaptive) {
+        return;
+    }
+
+    int32_t dot = speed->dot_us;
+
+    if (unit_us < dot / 2) {
+        unit_us = dot / 2;
+    } else if (unit_us > dot * 2) {
+        unit_us = dot * 2;
+    }
+
+    int32_t error = (int32_t)unit_us - dot;
+    set_dot(speed, dot + ((error < 0) ? -((-error) >> DOWN_SHIFT) : (error >> UP_SHIFT)));
+}
+
+void morse_speed_init(morse_speed_t *speed, int32_t initial_dot_us, int32_t glitch_us, bool adaptive)
+{
+    speed->dot_us = initial_dot_us;
+    speed->glitch_us = glitch_us;
+    speed->adaptive = adaptive;
+    speed->dash_q8 = UNITS_Q8(2);
+    speed->letter_q8 = UNITS_Q8(2);
+    speed->word_q8 = UNITS_Q8(5);
+    speed->tolerance_q8 = 0;
+    speed->jitter_us = 0;
+}
+
+void morse_speed_use_ml_thresholds(morse_speed_t *speed)
+{
+    speed->tolerance_q8 = 0;
+    speed->dash_q8 = UNITS_Q8(1.7320508);   // sqrt(1 * 3)
+    speed->letter_q8 = UNITS_Q8(1.7320508); // sqrt(1 * 3)
+    speed->word_q8 = UNITS_Q8(4.5825757);   // sqrt(3 * 7)
+}
+
+void morse_speed_set_tolerance(morse_speed_t *speed, int32_t tolerance_pct, int32_t jitter_us)
+{
+    speed->tolerance_q8 = (tolerance_pct * 256 + 50) / 100;
+    speed->jitter_us = jitter_us;
+    if (speed->tolerance_q8 == 0) {
+        speed->dash_q8 = UNITS_Q8(2);
+        speed->letter_q8 = UNITS_Q8(2);
+        speed->word_q8 = UNITS_Q8(5);
+    }
+    update_thresholds(speed);
+}
+
+// True if duration_us is at least threshold_q8 dot units
+static inline bool at_least(const morse_speed_t *speed, int64_t duration_us, int32_t threshold_q8)
+{
+    return duration_us * 256 >= (int64_t)threshold_q8 * speed->dot_us;
+}
+
+morse_pulse_t morse_speed_classify_pulse(morse_speed_t *speed, int64_t duration_us)
+{
+    // Longer than a dash at the slowest speed: the slicer re-baselining on
+    // ambient light, not the transmitter
+    if (duration_us < speed->glitch_us || duration_us > MORSE_SPEED_MAX_PULSE_US) {
+        return MORSE_PULSE_GLITCH;
+    }
+
+    if (speed->adaptive && duration_us >= 5 * (int64_t)speed->dot_us) {
+        set_dot(speed, duration_us / 3);
+        return MORSE_PULSE_DASH;
+    }
+    if (at_least(speed, duration_us, speed->dash_q8)) {
+        update_estimate(speed, duration_us / 3);
+        return MORSE_PULSE_DASH;
+    }
+
+    update_estimate(speed, duration_us);
+    return MORSE_PULSE_DOT;
+}
+
+morse_gap_t morse_speed_classify_gap(morse_speed_t *speed, int64_t duration_us)
+{
+    if (at_least(speed, duration_us, speed->word_q8)) {
+        // Word gaps include idle time between messages; don't learn from them
+        return MORSE_GAP_WORD;
+    }
+    if (at_least(speed, duration_us, speed->letter_q8)) {
+        update_estimate(speed, duration_us / 3);
+        return MORSE_GAP_LETTER;
+    }
+
+    update_estimate(speed, duration_us);
+    return MORSE_GAP_SYMBOL;
+}
+
+int32_t morse_speed_dot_us(const morse_speed_t *speed)
+{
+    return speed->dot_us;
+}
+
+int32_t morse_speed_letter_gap_us(const morse_speed_t *speed)
+{
+    return 3 * speed->dot_us;
+}
+
+int32_t morse_speed_word_gap_us(const morse_speed_t *speed)
+{
+    return 7 * speed->dot_us;
+}
+
+int32_t morse_speed_wpm(const morse_speed_t *speed)
+{
+    // PARIS standard: 50 units per word, so WPM = 1200 / dot in ms
+    return (1200000 + speed->dot_us / 2) / speed->dot_us;
+}
@@ -0,0 +1,113 @@
+/*
+ * Author: Noah Laforet
+ * File transfer accounting
+ */
+
+#include <string.h>
+#include "morse_transfer.h"
+
+#define START_TAG       "FILE"
+#define CHUNK_TAG       "FD"
+#define END_TAG         "FEND"
+
+// Fixed-width uppercase hex as the transmitter writes it; -1 if malformed
+static int64_t parse_hex(const char *text, size_t digits)
+{
+    int64_t value = 0;
+    for (size_t i = 0; i < digits; i++) {
+        char c = text[i];
+        if (c >= '0' && c <= '9') {
+            value = value * 16 + (c - '0');
+        } else if (c >= 'A' && c <= 'F') {
+            value = value * 16 + (c - 'A' + 10);
+        } else {
+            return -1;
+        }
+    }
+    return value;
+}
+
+static bool is_base32(const char *text, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (!((c >= 'A' && c <= 'Z') || (c >= '2' && c <= '7'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void morse_transfer_init(morse_transfer_t *transfer)
+{
+    memset(transfer, 0, sizeof(*transfer));
+}
+
+static morse_transfer_result_t put_start(morse_transfer_t *transfer, const char *payload, size_t length,
+                                         int64_t time_us)
+{
+    const size_t tag = sizeof(START_TAG) - 1;
+    if (length != tag + 4 + 8) {
+        return MORSE_TRANSFER_NONE;
+    }
+    int64_t chunks = parse_hex(payload + tag, 4);
+    int64_t bytes = parse_hex(payload + tag + 4, 8);
+    if (chunks <= 0 || chunks > MORSE_TRANSFER_MAX_CHUNKS || bytes < 0) {
+        return MORSE_TRANSFER_NONE;
+    }
+
+    morse_transfer_init(transfer);
+    transfer->active = true;
+    transfer->chunks = (uint16_t)chunks;
+    transfer->bytes = (uint32_t)bytes;
+    transfer->start_us = time_us;
+    transfer->last_us = time_us;
+    return MORSE_TRANSFER_STARTED;
+}
+
+static morse_transfer_result_t put_chunk(morse_transfer_t *transfer, const char *payload, size_t length,
+                                         int64_t time_us)
+{
+    const size_t header = sizeof(CHUNK_TAG) - 1 + 4;
+    if (!transfer->active || length <= header || !is_base32(payload + header, length - header)) {
+        return MORSE_TRANSFER_NONE;
+    }
+    int64_t index = parse_hex(payload + sizeof(CHUNK_TAG) - 1, 4);
+    if (index < 0 || index >= transfer->chunks) {
+        return MORSE_TRANSFER_NONE;
+    }
+
+    transfer->frames++;
+    uint8_t bit = (uint8_t)(1u << (index & 7));
+    if (transfer->seen[index >> 3] & bit) {
+        return MORSE_TRANSFER_REPEAT;
+    }
+    transfer->seen[index >> 3] |= bit;
+    transfer->received++;
+    transfer->bytes_received += (uint32_t)((length - header) * 5 / 8);     // Unpadded base32: 8 chars per 5 bytes
+    transfer->last_us = time_us;
+    return transfer->received == transfer->chunks ? MORSE_TRANSFER_DONE : MORSE_TRANSFER_CHUNK;
+}
+
+morse_transfer_result_t morse_transfer_put(morse_transfer_t *transfer, const char *payload, size_t length,
+                                           int64_t time_us)
+{
+    if (length == sizeof(END_TAG) - 1 && memcmp(payload, END_TAG, length) == 0) {
+        bool incomplete = transfer->active && transfer->received < transfer->chunks;
+        transfer->active = false;
+        return incomplete ? MORSE_TRANSFER_ENDED : MORSE_TRANSFER_NONE;
+    }
+    if (length >= sizeof(START_TAG) - 1 && memcmp(payload, START_TAG, sizeof(START_TAG) - 1) == 0) {
+        return put_start(transfer, payload, length, time_us);
+    }
+    if (length >= sizeof(CHUNK_TAG) - 1 && memcmp(payload, CHUNK_TAG, sizeof(CHUNK_TAG) - 1) == 0) {
+        return put_chunk(transfer, payload, length, time_us);
+    }
+    return MORSE_TRANSFER_NONE;
+}
+
+uint32_t morse_transfer_goodput(const morse_transfer_t *transfer)
+{
+    int64_t elapsed_us = transfer->last_us - transfer->start_us;
+    return elapsed_us > 0 ? (uint32_t)((int64_t)transfer->bytes_received * 1000000 / elapsed_us) : 0;
+}
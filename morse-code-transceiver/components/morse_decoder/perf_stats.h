@@ -0,0 +1,77 @@
+/*
+ * Author: Noah Laforet
+ * Hot-path timing counters
+ *
+ * Each stage keeps a count, total, min/max and a histogram of power-of-two
+ * buckets (bucket b holds values in [2^(b-1), 2^b), bucket 0 holds zero),
+ * so a stage costs a few adds per sample and never allocates. Values are
+ * whatever the caller measures: CPU cycles for work, microseconds for
+ * intervals and jitter. Each stage is written by one task only, resets
+ * included: a reset just moves the caller's generation counter on, and the
+ * writer clears the stage at its next sample once it sees the new value.
+ * Readers (the "stats" console command) take a copy and may see a sample
+ * half-applied, which is fine for diagnostics; a copy from an older
+ * generation reads as empty.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define PERF_HIST_BUCKETS   24      // Last bucket also holds everything >= 2^22
+
+typedef struct {
+    uint32_t generation;    // Reset generation the stage was last cleared for
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[PERF_HIST_BUCKETS];
+} perf_stage_t;
+
+static inline void perf_stage_reset(perf_stage_t *stage, uint32_t generation)
+{
+    memset(stage, 0, sizeof(*stage));
+    stage->generation = generation;
+    stage->min = UINT32_MAX;
+}
+
+// Readers only: a copy that is empty until the writer catches up with a reset
+static inline perf_stage_t perf_stage_read(const perf_stage_t *stage, uint32_t generation)
+{
+    perf_stage_t copy = *stage;
+    if (copy.generation != generation) {
+        perf_stage_reset(&copy, generation);
+    }
+    return copy;
+}
+
+static inline unsigned perf_bucket(uint32_t value)
+{
+    unsigned bucket = value ? 32 - (unsigned)__builtin_clz(value) : 0;
+    return bucket < PERF_HIST_BUCKETS ? bucket : PERF_HIST_BUCKETS - 1;
+}
+
+// Lower bound of a bucket, for printing
+static inline uint32_t perf_bucket_floor(unsigned bucket)
+{
+    return bucket ? 1u << (bucket - 1) : 0;
+}
+
+// Writer only: clears the stage first if the generation has moved on
+static inline void perf_stage_add(perf_stage_t *stage, uint32_t generation, uint32_t value)
+{
+    if (stage->generation != generation) {
+        perf_stage_reset(stage, generation);
+    }
+    stage->count++;
+    stage->total += value;
+    if (value < stage->min) {
+        stage->min = value;
+    }
+    if (value > stage->max) {
+        stage->max = value;
+    }
+    stage->hist[perf_bucket(value)]++;
+}
@@ -0,0 +1,171 @@
+/*
+ * Author: Noah Laforet
+ * Decoder throughput benchmark
+ *
+ * For every profile, with and without the DSP front end, decodes a pangram
+ * at the profile's nominal dot over several seeds, then keys it faster and
+ * faster until a seed fails. Reports the CER at the nominal dot, the decode
+ * cost per sample and the fastest dot (and chars/s) every seed survived.
+ * Exits non-zero if any profile can't decode its own nominal speed, so the
+ * bench doubles as a regression check for decoder changes.
+ *
+ *   morse_bench [--seeds N] [--tolerance-pct N] [--timing-jitter-us N] [channel options]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_trace.h"
+#include "sim_rx.h"
+#include "morse_profile.h"
+
+#define BENCH_TEXT      "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789"
+#define BENCH_SEEDS     5
+#define CHANNEL_ARGS    32
+
+// Dot lengths tried, as a fraction of the profile's nominal dot
+static const double dot_factors[] = {1.0, 0.75, 0.5, 0.35, 0.25, 0.18, 0.125, 0.09, 0.0625};
+
+typedef struct {
+    double worst_cer;
+    double ns_per_sample;       // Mean over the seeds
+    double chars_per_s;
+} bench_point_t;
+
+typedef struct {
+    const char *args[CHANNEL_ARGS][2];
+    int count;
+} channel_args_t;
+
+static bool configure_channel(sim_channel_t *channel, const morse_profile_t *profile, int32_t dot_us,
+                              const channel_args_t *args, uint32_t seed)
+{
+    sim_channel_defaults(channel, profile->sample_freq_hz, dot_us);
+    for (int i = 0; i < args->count; i++) {
+        if (!sim_channel_option(channel, args->args[i][0], args->args[i][1])) {
+            fprintf(stderr, "Unknown option '%s'\n", args->args[i][0]);
+            return false;
+        }
+    }
+    channel->seed += seed;
+    return true;
+}
+
+static bool run_point(const sim_rx_config_t *config, int32_t dot_us, int seeds,
+                      const channel_args_t *args, const char *sent, bench_point_t *point)
+{
+    static sim_rx_result_t result;
+    const morse_profile_t *profile = config->profile;
+
+    memset(point, 0, sizeof(*point));
+    for (int seed = 0; seed < seeds; seed++) {
+        sim_channel_t channel;
+        if (!configure_channel(&channel, profile, dot_us, args, (uint32_t)seed)) {
+            return false;
+        }
+
+        sim_trace_t trace;
+        if (!sim_trace_generate(&channel, BENCH_TEXT, &trace)) {
+            fprintf(stderr, "Out of memory generating the trace\n");
+            return false;
+        }
+        sim_rx_run(config, trace.samples, trace.count, &result);
+
+        double cer = sim_char_error_rate(sent, result.text);
+        if (cer > point->worst_cer) {
+            point->worst_cer = cer;
+        }
+        point->ns_per_sample += result.ns_per_sample / seeds;
+        point->chars_per_s = trace.chars / trace.on_air_s;
+        sim_trace_free(&trace);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int seeds = BENCH_SEEDS;
+    int32_t tolerance_pct = SIM_RX_TOLERANCE_PCT;
+    int32_t timing_jitter_us = 0;
+    channel_args_t args = {.count = 0};
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc || strncmp(argv[i], "--", 2) != 0) {
+            fprintf(stderr, "Usage: %s [--seeds N] [--tolerance-pct N] [--timing-jitter-us N] [channel options]\n",
+                    argv[0]);
+            fputs(sim_channel_usage(), stderr);
+            return 2;
+        }
+        if (strcmp(argv[i], "--seeds") == 0) {
+            seeds = atoi(argv[++i]);
+            if (seeds < 1) {
+                seeds = 1;
+            }
+        } else if (strcmp(argv[i], "--tolerance-pct") == 0) {
+            tolerance_pct = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timing-jitter-us") == 0) {
+            timing_jitter_us = atoi(argv[++i]);
+        } else if (args.count < CHANNEL_ARGS) {
+            args.args[args.count][0] = argv[i];
+            args.args[args.count][1] = argv[++i];
+            args.count++;
+        }
+    }
+
+    char sent[sizeof(BENCH_TEXT)];
+    sim_sendable_text(BENCH_TEXT, sent);
+
+    printf("%-14s %8s %9s %8s %10s %11s %10s\n",
+           "profile", "dot (us)", "CER", "ns/samp", "% realtime", "max dot", "max chr/s");
+
+    bool nominal_ok = true;
+    for (int id = 0; id < MORSE_PROFILE_COUNT; id++) {
+        const morse_profile_t *profile = morse_profile_get((morse_profile_id_t)id);
+
+        for (int dsp = 0; dsp <= 1; dsp++) {
+            sim_rx_config_t config = {
+                .profile = profile,
+                .sample_freq_hz = profile->sample_freq_hz,
+                .dsp = dsp,
+                .tolerance_pct = tolerance_pct,
+                .jitter_us = timing_jitter_us,
+            };
+            int32_t nominal_us = profile->dot_us;
+            bench_point_t nominal;
+            if (!run_point(&config, nominal_us, seeds, &args, sent, &nominal)) {
+                return 2;
+            }
+
+            // Fastest dot every seed decodes perfectly, stopping at the first failure
+            int32_t best_us = 0;
+            double best_rate = 0.0;
+            if (nominal.worst_cer == 0.0) {
+                best_us = nominal_us;
+                best_rate = nominal.chars_per_s;
+                for (size_t f = 1; f < sizeof(dot_factors) / sizeof(dot_factors[0]); f++) {
+                    int32_t dot_us = (int32_t)(nominal_us * dot_factors[f]);
+                    bench_point_t point;
+                    if (!run_point(&config, dot_us, seeds, &args, sent, &point)) {
+                        return 2;
+                    }
+                    if (point.worst_cer > 0.0) {
+                        break;
+                    }
+                    best_us = dot_us;
+                    best_rate = point.chars_per_s;
+                }
+            } else {
+                nominal_ok = false;
+            }
+
+            char name[32];
+            snprintf(name, sizeof(name), "%s%s", profile->name, dsp ? "+dsp" : "");
+            printf("%-14s %8ld %9.4f %8.1f %9.2f%% %8ld us %10.1f\n", name, (long)nominal_us, nominal.worst_cer,
+                   nominal.ns_per_sample, nominal.ns_per_sample * profile->sample_freq_hz / 1e7,
+                   (long)best_us, best_rate);
+        }
+    }
+
+    printf("\n%d seed(s) per point; CER is the worst seed at the nominal dot\n", seeds);
+    return nominal_ok ? 0 : 1;
+}
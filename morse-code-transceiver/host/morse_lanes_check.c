@@ -0,0 +1,320 @@
+/*
+ * Author: Noah Laforet
+ * Lane reassembly check: striped frames keyed on lockstep lanes
+ *
+ *   morse_lanes_check [--lanes N] [--messages N] [--end-units N] [--drop SEQ]... TEXT
+ *
+ * Stripes TEXT over N lanes as transmitter/src/morse_lanes.py does (the same
+ * number of frames per lane, frame k on lane k mod N, a running sequence
+ * number over --messages messages), keys every lane in lockstep on the
+ * transmitter's timing model and hands each lane's characters to its own
+ * frame parser at the time the decoder would resolve them. Each lane's
+ * message ends --end-units dot units after its last character, so with
+ * letters of different lengths the lanes end at different times, as on air.
+ * --drop keys that frame with a bad CRC.
+ *
+ * morse_lanes must deliver every frame that wasn't dropped, in sequence
+ * order, and report the dropped ones in between as lost. Prints what was
+ * delivered and exits non-zero if that isn't so.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_trace.h"
+#include "morse_frame.h"
+#include "morse_lanes.h"
+
+#define CHECK_LANES_MAX     MORSE_LANES_MAX
+#define CHECK_FRAMES_MAX    256
+#define CHECK_DROPS_MAX     16
+#define FRAME_PAYLOAD       64      // MAX_PAYLOAD in morse_frame.py
+#define END_UNITS           14      // The decoder ends a message after two word gaps
+#define FRAME_TEXT_MAX      (4 + 1 + MORSE_FRAME_BODY_MAX + 1 + 1)    // EEEE <KA> body <AR> NUL
+
+typedef struct {
+    uint8_t seq;
+    int message;
+    bool dropped;
+    char payload[MORSE_FRAME_PAYLOAD_MAX + 1];
+} sent_frame_t;
+
+typedef struct {
+    uint32_t time;              // Dot units from the start of the first message
+    uint32_t order;             // Ties keep each lane's characters in the order keyed
+    uint8_t lane;
+    char c;                     // 0: end of message
+} key_event_t;
+
+typedef struct {
+    key_event_t *events;
+    size_t count;
+    size_t capacity;
+} event_list_t;
+
+static sent_frame_t sent[CHECK_FRAMES_MAX];
+static int sent_count = 0;
+static morse_lanes_t lanes;
+static bool failed = false;
+static int next_expected = 0;   // Index into sent[] of the next frame that should come out
+static int last_message = -1;   // Message of the last frame delivered
+
+/*---------------------------------------------------------------
+        Transmitter (morse_frame.py, morse_lanes.py)
+---------------------------------------------------------------*/
+// EEEE <KA> T SS LL payload CCCC <AR>
+static void encode_frame(const char *payload, uint8_t seq, bool bad_crc, char *out, size_t size)
+{
+    char body[MORSE_FRAME_HEADER_LEN + MORSE_FRAME_PAYLOAD_MAX + 1];
+    size_t length = strlen(payload);
+    int header = snprintf(body, sizeof(body), "0%02X%02X%s", seq, (unsigned)length, payload);
+    uint16_t crc = morse_crc16(body, (size_t)header);
+    snprintf(out, size, "EEEE%c%s%04X%c", MORSE_FRAME_STX, body, (unsigned)(bad_crc ? crc ^ 1 : crc), MORSE_FRAME_ETX);
+}
+
+// Dot units a character takes, letter gap included
+static uint32_t char_units(char c)
+{
+    if (c == ' ') {
+        return 7 - 3;           // A letter gap already follows the previous character
+    }
+    if (c == MORSE_FRAME_STX) {
+        return 15 + 3;          // -.-.-
+    }
+    if (c == MORSE_FRAME_ETX) {
+        return 13 + 3;          // .-.-.
+    }
+    char letter[2] = {c, '\0'};
+    return sim_message_units(letter) + 3;
+}
+
+static bool add_event(event_list_t *list, uint32_t time, uint8_t lane, char c)
+{
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? 2 * list->capacity : 1024;
+        key_event_t *events = realloc(list->events, capacity * sizeof(*events));
+        if (events == NULL) {
+            return false;
+        }
+        list->events = events;
+        list->capacity = capacity;
+    }
+    list->events[list->count] = (key_event_t){.time = time, .order = (uint32_t)list->count, .lane = lane, .c = c};
+    list->count++;
+    return true;
+}
+
+static bool is_dropped(uint8_t seq, const int *drops, int drop_count)
+{
+    for (int i = 0; i < drop_count; i++) {
+        if ((uint8_t)drops[i] == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// One message striped over the lanes from `start`; returns when the last lane ends
+static bool key_message(const char *text, int message, int lane_count, uint8_t *seq, uint32_t start,
+                        const int *drops, int drop_count, event_list_t *list, uint32_t end_units, uint32_t *end)
+{
+    size_t length = strlen(text);
+    size_t per_lane = (length + (size_t)lane_count * FRAME_PAYLOAD - 1) / ((size_t)lane_count * FRAME_PAYLOAD);
+    per_lane = per_lane ? per_lane : 1;
+    size_t max_payload = (length + (size_t)lane_count * per_lane - 1) / ((size_t)lane_count * per_lane);
+    max_payload = max_payload ? max_payload : 1;
+    int frames = (int)((length + max_payload - 1) / max_payload);
+    frames = frames ? frames : 1;
+
+    uint32_t lane_time[CHECK_LANES_MAX];
+    for (int lane = 0; lane < lane_count; lane++) {
+        lane_time[lane] = start;
+    }
+    for (int k = 0; k < frames; k++) {
+        if (sent_count == CHECK_FRAMES_MAX) {
+            return false;
+        }
+        sent_frame_t *frame = &sent[sent_count++];
+        size_t offset = (size_t)k * max_payload;
+        size_t chunk = offset < length ? length - offset : 0;
+        chunk = chunk < max_payload ? chunk : max_payload;
+        memcpy(frame->payload, text + offset, chunk);
+        frame->payload[chunk] = '\0';
+        frame->seq = (*seq)++;
+        frame->message = message;
+        frame->dropped = is_dropped(frame->seq, drops, drop_count);
+
+        char keyed[FRAME_TEXT_MAX];
+        encode_frame(frame->payload, frame->seq, frame->dropped, keyed, sizeof(keyed));
+        int lane = k % lane_count;
+        if (lane_time[lane] != start && !add_event(list, lane_time[lane] += char_units(' '), (uint8_t)lane, ' ')) {
+            return false;   // Frames on one lane are joined by word gaps
+        }
+        for (const char *p = keyed; *p; p++) {
+            lane_time[lane] += char_units(*p);
+            if (!add_event(list, lane_time[lane], (uint8_t)lane, *p)) {
+                return false;
+            }
+        }
+    }
+
+    *end = start;
+    for (int lane = 0; lane < lane_count; lane++) {
+        // A lane without frames stays dark and never ends a message
+        if (lane_time[lane] != start && !add_event(list, lane_time[lane] + end_units, (uint8_t)lane, 0)) {
+            return false;
+        }
+        if (lane_time[lane] + end_units > *end) {
+            *end = lane_time[lane] + end_units;
+        }
+    }
+    return true;
+}
+
+static int compare_events(const void *a, const void *b)
+{
+    const key_event_t *x = a, *y = b;
+    if (x->time != y->time) {
+        return x->time < y->time ? -1 : 1;
+    }
+    return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+/*---------------------------------------------------------------
+        Receiver (morse_rx.c)
+---------------------------------------------------------------*/
+static void on_frame(const morse_frame_t *frame, void *ctx)
+{
+    morse_lanes_put(&lanes, (uint8_t)(uintptr_t)ctx, frame);
+}
+
+static void on_stripe(uint8_t seq, const char *payload, uint8_t length, uint8_t lost, void *ctx)
+{
+    (void)ctx;
+    // Only a gap behind a delivered frame of the same message can be seen
+    int lost_expected = 0;
+    while (next_expected < sent_count && sent[next_expected].dropped) {
+        lost_expected += sent[next_expected].message == last_message;
+        next_expected++;
+    }
+
+    printf("#%02X%s: %.*s\n", seq, lost ? " (after lost frames)" : "", length, payload);
+    if (next_expected == sent_count || sent[next_expected].seq != seq ||
+        strcmp(sent[next_expected].payload, payload) != 0) {
+        if (next_expected < sent_count) {
+            printf("  out of order: expected #%02X\n", sent[next_expected].seq);
+        } else {
+            printf("  out of order\n");
+        }
+        failed = true;
+        // Resynchronise on the frame that came out, so one error is reported once
+        while (next_expected < sent_count && sent[next_expected].seq != seq) {
+            next_expected++;
+        }
+    } else if (lost != lost_expected) {
+        printf("  %u frame(s) reported lost, expected %d\n", lost, lost_expected);
+        failed = true;
+    }
+    if (next_expected < sent_count) {
+        last_message = sent[next_expected].message;
+        next_expected++;
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [options] TEXT\n"
+                    "  --lanes N            LEDs and photodiodes (default 3, at most %d)\n"
+                    "  --messages N         send TEXT this many times (default 1)\n"
+                    "  --end-units N        end of message after the last character, dot units (default %d)\n"
+                    "  --drop SEQ           key frame SEQ with a bad CRC (up to %d times)\n",
+            argv0, CHECK_LANES_MAX, END_UNITS, CHECK_DROPS_MAX);
+}
+
+int main(int argc, char **argv)
+{
+    int lane_count = 3;
+    int messages = 1;
+    uint32_t end_units = END_UNITS;
+    int drops[CHECK_DROPS_MAX];
+    int drop_count = 0;
+    const char *text = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--", 2) == 0 && i + 1 < argc) {
+            long value = strtol(argv[++i], NULL, 0);
+            if (strcmp(arg, "--lanes") == 0) {
+                lane_count = (int)value;
+            } else if (strcmp(arg, "--messages") == 0) {
+                messages = (int)value;
+            } else if (strcmp(arg, "--end-units") == 0) {
+                end_units = (uint32_t)value;
+            } else if (strcmp(arg, "--drop") == 0 && drop_count < CHECK_DROPS_MAX) {
+                drops[drop_count++] = (int)value;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (text == NULL && strncmp(arg, "--", 2) != 0) {
+            text = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (text == NULL || lane_count < 1 || lane_count > CHECK_LANES_MAX || messages < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char *sendable = malloc(strlen(text) + 1);
+    if (sendable == NULL) {
+        return 1;
+    }
+    sim_sendable_text(text, sendable);
+
+    event_list_t list = {0};
+    uint8_t seq = 0;
+    uint32_t start = 0;
+    for (int message = 0; message < messages; message++) {
+        uint32_t end;
+        if (!key_message(sendable, message, lane_count, &seq, start, drops, drop_count, &list, end_units, &end)) {
+            fprintf(stderr, "Out of memory keying the lanes\n");
+            free(sendable);
+            free(list.events);
+            return 1;
+        }
+        start = end + 7;        // The next message follows once every lane has finished
+    }
+    qsort(list.events, list.count, sizeof(*list.events), compare_events);
+
+    static morse_frame_parser_t parsers[CHECK_LANES_MAX];
+    for (int lane = 0; lane < lane_count; lane++) {
+        morse_frame_init(&parsers[lane], on_frame, (void *)(uintptr_t)lane);
+    }
+    morse_lanes_init(&lanes, (uint8_t)lane_count, on_stripe, NULL);
+    for (size_t i = 0; i < list.count; i++) {
+        const key_event_t *event = &list.events[i];
+        if (event->c != 0) {
+            morse_frame_put(&parsers[event->lane], event->c);
+        } else {
+            morse_frame_end(&parsers[event->lane]);
+            morse_lanes_end(&lanes, event->lane);
+        }
+    }
+
+    while (next_expected < sent_count && sent[next_expected].dropped) {
+        next_expected++;
+    }
+    if (next_expected != sent_count) {
+        printf("Frame #%02X and after never delivered\n", sent[next_expected].seq);
+        failed = true;
+    }
+    printf("%d frame(s) sent over %d lane(s), %lu delivered in order, %lu lost: %s\n", sent_count, lane_count,
+           (unsigned long)lanes.frames_ok, (unsigned long)lanes.frames_lost, failed ? "FAIL" : "OK");
+
+    free(sendable);
+    free(list.events);
+    return failed ? 1 : 0;
+}
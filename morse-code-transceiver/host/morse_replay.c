@@ -0,0 +1,307 @@
+/*
+ * Author: Noah Laforet
+ * Replay a receiver capture through the host receiver
+ *
+ *   morse_replay [--profile NAME] [--channel N] [--dsp] [tuning options] [--expect TEXT] [--dump FILE] CAPTURE
+ *
+ * CAPTURE holds the blocks of a receiver built with CONFIG_MORSE_CAPTURE, as
+ * recorded by tools/morse_capture.py or straight from the serial port: other
+ * bytes (log text) are skipped. Every channel found is rebuilt on its capture
+ * clock, with lost blocks bridged by holding the last sample, and decoded by
+ * sim_rx with the same slicer, filter and timing model as the firmware. The
+ * slicer and timing options override the firmware defaults, so one capture
+ * can be decoded again and again while tuning them. --expect scores the
+ * result against the text that was sent; --dump writes one channel as raw
+ * uint16 samples, like morse_sim --dump.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_trace.h"
+#include "sim_rx.h"
+#include "morse_capture.h"
+#include "morse_profile.h"
+
+#define REPLAY_MAX_CHANNELS     8
+
+typedef struct {
+    uint16_t *samples;
+    size_t count;
+    size_t capacity;
+    uint32_t sample_freq_hz;
+    uint16_t decimation;
+    uint32_t base;              // Capture clock of samples[0]: recording may start mid-run
+    uint32_t blocks;
+    uint32_t dropped;           // Blocks the receiver reported lost
+    size_t held;                // Samples bridged over lost blocks
+} replay_channel_t;
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [options] CAPTURE\n"
+                    "  --profile NAME       standard, fast or ultra-fast (default: the one with the capture's rate)\n"
+                    "  --channel N          replay only this channel (default all)\n"
+                    "  --dsp                matched filter and ML thresholds (CONFIG_MORSE_DSP)\n"
+                    "  --tolerance-pct N    timing tolerance model, 0 for midpoints (default 10)\n"
+                    "  --timing-jitter-us N edge jitter for the model (default: one sample period)\n"
+                    "  --calibration-ms N   ambient calibration at the start (default %d)\n"
+                    "  --min-swing N        smallest light swing the slicer accepts, counts (default %d)\n"
+                    "  --glitch-us N        glitch filter (default %d)\n"
+                    "  --threshold N        fixed slicer threshold in counts instead of calibrating\n"
+                    "  --expect TEXT        text that was sent: report the character error rate\n"
+                    "  --dump FILE          write the replayed channel as raw uint16 samples\n",
+            argv0, SIM_RX_CALIBRATION_MS, SIM_RX_MIN_SWING, SIM_RX_GLITCH_US);
+}
+
+static const morse_profile_t *find_profile(const char *name)
+{
+    for (int id = 0; id < MORSE_PROFILE_COUNT; id++) {
+        const morse_profile_t *profile = morse_profile_get((morse_profile_id_t)id);
+        if (strcmp(profile->name, name) == 0) {
+            return profile;
+        }
+    }
+    return NULL;
+}
+
+// The profile the receiver ran: its ADC rate is the capture's before decimation
+static const morse_profile_t *capture_profile(const replay_channel_t *channel)
+{
+    for (int id = 0; id < MORSE_PROFILE_COUNT; id++) {
+        const morse_profile_t *profile = morse_profile_get((morse_profile_id_t)id);
+        if (profile->sample_freq_hz == channel->sample_freq_hz * channel->decimation) {
+            return profile;
+        }
+    }
+    return morse_profile_get(MORSE_PROFILE_FAST);
+}
+
+static bool append(replay_channel_t *channel, uint16_t value, size_t repeat)
+{
+    if (channel->count + repeat > channel->capacity) {
+        size_t capacity = channel->capacity ? channel->capacity : 65536;
+        while (capacity < channel->count + repeat) {
+            capacity *= 2;
+        }
+        uint16_t *samples = realloc(channel->samples, capacity * sizeof(*samples));
+        if (samples == NULL) {
+            return false;
+        }
+        channel->samples = samples;
+        channel->capacity = capacity;
+    }
+    for (size_t i = 0; i < repeat; i++) {
+        channel->samples[channel->count++] = value;
+    }
+    return true;
+}
+
+static bool add_block(replay_channel_t *channel, const morse_capture_block_t *block)
+{
+    if (channel->blocks == 0) {
+        channel->sample_freq_hz = block->sample_freq_hz;
+        channel->decimation = block->decimation;
+        channel->base = block->first_sample;
+    } else if (block->sample_freq_hz != channel->sample_freq_hz) {
+        return true;    // A different run of the receiver; keep the first
+    }
+
+    // The capture clock is 32 bits: the gap is taken modulo 2^32
+    uint32_t expected = channel->base + (uint32_t)channel->count;
+    uint32_t gap = block->first_sample - expected;
+    if (channel->blocks > 0 && gap >= 0x80000000u) {
+        return true;    // Already have it
+    }
+    if (channel->blocks > 0 && gap > 0) {
+        if (!append(channel, channel->samples[channel->count - 1], gap)) {
+            return false;
+        }
+        channel->held += gap;
+    }
+    channel->blocks++;
+    channel->dropped += block->dropped;
+    for (uint16_t i = 0; i < block->count; i++) {
+        if (!append(channel, block->samples[i], 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint8_t *read_file(const char *path, size_t *length)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t capacity = 1 << 20;
+    uint8_t *data = malloc(capacity);
+    *length = 0;
+    while (data != NULL) {
+        *length += fread(data + *length, 1, capacity - *length, file);
+        if (*length < capacity) {
+            break;
+        }
+        capacity *= 2;
+        uint8_t *grown = realloc(data, capacity);
+        if (grown == NULL) {
+            free(data);
+        }
+        data = grown;
+    }
+    fclose(file);
+    return data;
+}
+
+static bool write_trace(const char *path, const replay_channel_t *channel)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    bool ok = fwrite(channel->samples, sizeof(*channel->samples), channel->count, file) == channel->count;
+    return fclose(file) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+    const morse_profile_t *profile = NULL;
+    int only_channel = -1;
+    sim_rx_config_t config = {
+        .tolerance_pct = SIM_RX_TOLERANCE_PCT,
+    };
+    const char *expect = NULL;
+    const char *dump = NULL;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--dsp") == 0) {
+            config.dsp = true;
+        } else if (strncmp(arg, "--", 2) == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (strcmp(arg, "--profile") == 0) {
+                profile = find_profile(value);
+                if (profile == NULL) {
+                    fprintf(stderr, "Unknown profile '%s'\n", value);
+                    return 2;
+                }
+            } else if (strcmp(arg, "--channel") == 0) {
+                only_channel = (int)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--tolerance-pct") == 0) {
+                config.tolerance_pct = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--timing-jitter-us") == 0) {
+                config.jitter_us = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--calibration-ms") == 0) {
+                config.calibration_ms = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--min-swing") == 0) {
+                config.min_swing = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--glitch-us") == 0) {
+                config.glitch_us = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--threshold") == 0) {
+                config.threshold = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--expect") == 0) {
+                expect = value;
+            } else if (strcmp(arg, "--dump") == 0) {
+                dump = value;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (path == NULL && strncmp(arg, "--", 2) != 0) {
+            path = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t length;
+    uint8_t *data = read_file(path, &length);
+    if (data == NULL) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+
+    // Blocks anywhere in the byte stream; everything else is console text
+    static replay_channel_t channels[REPLAY_MAX_CHANNELS];
+    static morse_capture_block_t block;
+    size_t other_bytes = 0;
+    uint32_t blocks = 0;
+    for (size_t offset = 0; offset < length;) {
+        size_t used = morse_capture_unpack(data + offset, length - offset, &block);
+        if (used == 0) {
+            offset++;
+            other_bytes++;
+            continue;
+        }
+        offset += used;
+        blocks++;
+        if (block.channel < REPLAY_MAX_CHANNELS && !add_block(&channels[block.channel], &block)) {
+            fprintf(stderr, "Out of memory rebuilding channel %u\n", block.channel);
+            free(data);
+            return 1;
+        }
+    }
+    free(data);
+    printf("Capture:   %s, %lu blocks, %zu bytes of other console output\n", path, (unsigned long)blocks, other_bytes);
+
+    char *sent = NULL;
+    if (expect != NULL) {
+        sent = malloc(strlen(expect) + 1);
+        if (sent == NULL) {
+            return 1;
+        }
+        sim_sendable_text(expect, sent);
+        printf("Sent:      %s\n", sent);
+    }
+
+    int replayed = 0;
+    static sim_rx_result_t result;
+    for (int c = 0; c < REPLAY_MAX_CHANNELS; c++) {
+        const replay_channel_t *channel = &channels[c];
+        if (channel->blocks == 0 || (only_channel >= 0 && c != only_channel)) {
+            continue;
+        }
+        replayed++;
+
+        config.profile = profile != NULL ? profile : capture_profile(channel);
+        config.sample_freq_hz = channel->sample_freq_hz;
+        sim_rx_run(&config, channel->samples, channel->count, &result);
+
+        printf("\n[ch%d]     %zu samples at %lu Hz (decimation %u), %.3f s; %lu block(s) lost, %zu samples held\n",
+               c, channel->count, (unsigned long)channel->sample_freq_hz, channel->decimation,
+               (double)channel->count / channel->sample_freq_hz, (unsigned long)channel->dropped, channel->held);
+        printf("Profile:   %s%s\n", config.profile->name, config.dsp ? " + DSP" : "");
+        printf("Received:  %s\n", result.text);
+        if (sent != NULL) {
+            printf("CER:       %.4f\n", sim_char_error_rate(sent, result.text));
+        }
+        printf("Edges:     %lu, messages %lu, dot estimate %ld us\n", (unsigned long)result.edges,
+               (unsigned long)result.messages, (long)result.dot_us);
+        printf("Decode:    %.1f ns/sample\n", result.ns_per_sample);
+
+        if (dump != NULL) {
+            if (replayed > 1) {
+                fprintf(stderr, "--dump writes one channel; pick it with --channel\n");
+            } else if (!write_trace(dump, channel)) {
+                fprintf(stderr, "Failed to write %s\n", dump);
+            }
+        }
+    }
+    free(sent);
+    for (int c = 0; c < REPLAY_MAX_CHANNELS; c++) {
+        free(channels[c].samples);
+    }
+
+    if (replayed == 0) {
+        fprintf(stderr, "No capture blocks%s in %s\n", only_channel >= 0 ? " for that channel" : "", path);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Author: Noah Laforet
+ * Simulate one message end to end: text -> ADC trace -> host receiver
+ *
+ *   morse_sim [--profile fast] [--dot-us N] [--dsp] [--tolerance-pct N] [channel options] [--dump FILE]
+ *             [--capture FILE] [--capture-start N] "TEXT"
+ *
+ * --dump writes the raw trace as little-endian uint16 samples for plotting.
+ * --capture writes it in the receiver's capture block format instead, for
+ * trying out morse_replay without a receiver; --capture-start N numbers the
+ * first block's samples from N, as when recording joins a running receiver.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_trace.h"
+#include "sim_rx.h"
+#include "morse_profile.h"
+#include "morse_capture.h"
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [options] TEXT\n"
+                    "  --profile NAME       standard, fast or ultra-fast (default fast)\n"
+                    "  --dot-us N           keyed dot length (default: the profile's dot)\n"
+                    "  --dsp                matched filter and ML thresholds (CONFIG_MORSE_DSP)\n"
+                    "  --tolerance-pct N    timing tolerance model, 0 for midpoints (default 10)\n"
+                    "  --timing-jitter-us N edge jitter for the model (default: one sample period)\n"
+                    "  --dump FILE          write the raw uint16 trace to FILE\n"
+                    "  --capture FILE       write the trace as receiver capture blocks to FILE\n"
+                    "  --capture-start N    capture clock of the first sample (default 0)\n",
+            argv0);
+    fputs(sim_channel_usage(), stderr);
+}
+
+static const morse_profile_t *find_profile(const char *name)
+{
+    for (int id = 0; id < MORSE_PROFILE_COUNT; id++) {
+        const morse_profile_t *profile = morse_profile_get((morse_profile_id_t)id);
+        if (strcmp(profile->name, name) == 0) {
+            return profile;
+        }
+    }
+    return NULL;
+}
+
+// As CONFIG_MORSE_CAPTURE would send it: full blocks only
+static bool write_capture(const char *path, const sim_trace_t *trace, uint32_t sample_freq_hz, uint32_t first_sample)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    static morse_capture_t capture;
+    static uint8_t block[MORSE_CAPTURE_BLOCK_MAX];
+    morse_capture_init(&capture, 0, sample_freq_hz, 1);
+    capture.next_sample = first_sample;
+    bool ok = true;
+    for (size_t n = 0; n < trace->count && ok; n++) {
+        if (morse_capture_add(&capture, trace->samples[n])) {
+            size_t length = morse_capture_seal(block, morse_capture_pack(&capture, block));
+            ok = fwrite(block, 1, length, file) == length;
+        }
+    }
+    return fclose(file) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+    const morse_profile_t *profile = morse_profile_get(MORSE_PROFILE_FAST);
+    int32_t dot_us = 0;
+    bool dsp = false;
+    int32_t tolerance_pct = SIM_RX_TOLERANCE_PCT;
+    int32_t timing_jitter_us = 0;
+    const char *dump = NULL;
+    const char *capture = NULL;
+    uint32_t capture_start = 0;
+    const char *text = NULL;
+
+    // Channel options are collected first and applied once the profile (and its rate) is known
+    const char *channel_args[32][2];
+    int channel_argc = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--dsp") == 0) {
+            dsp = true;
+        } else if (strncmp(arg, "--", 2) == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (strcmp(arg, "--profile") == 0) {
+                profile = find_profile(value);
+                if (profile == NULL) {
+                    fprintf(stderr, "Unknown profile '%s'\n", value);
+                    return 2;
+                }
+            } else if (strcmp(arg, "--dot-us") == 0) {
+                dot_us = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--tolerance-pct") == 0) {
+                tolerance_pct = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--timing-jitter-us") == 0) {
+                timing_jitter_us = (int32_t)strtol(value, NULL, 0);
+            } else if (strcmp(arg, "--dump") == 0) {
+                dump = value;
+            } else if (strcmp(arg, "--capture") == 0) {
+                capture = value;
+            } else if (strcmp(arg, "--capture-start") == 0) {
+                capture_start = (uint32_t)strtoul(value, NULL, 0);
+            } else if (channel_argc < 32) {
+                channel_args[channel_argc][0] = arg;
+                channel_args[channel_argc][1] = value;
+                channel_argc++;
+            }
+        } else if (text == NULL && strncmp(arg, "--", 2) != 0) {
+            text = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (text == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    sim_channel_t channel;
+    sim_channel_defaults(&channel, profile->sample_freq_hz, dot_us > 0 ? dot_us : profile->dot_us);
+    for (int i = 0; i < channel_argc; i++) {
+        if (!sim_channel_option(&channel, channel_args[i][0], channel_args[i][1])) {
+            fprintf(stderr, "Unknown option '%s'\n", channel_args[i][0]);
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    sim_trace_t trace;
+    if (!sim_trace_generate(&channel, text, &trace)) {
+        fprintf(stderr, "Out of memory generating the trace\n");
+        return 1;
+    }
+
+    if (dump != NULL) {
+        FILE *file = fopen(dump, "wb");
+        if (file == NULL || fwrite(trace.samples, sizeof(*trace.samples), trace.count, file) != trace.count) {
+            fprintf(stderr, "Failed to write %s\n", dump);
+            if (file != NULL) {
+                fclose(file);
+            }
+            sim_trace_free(&trace);
+            return 1;
+        }
+        fclose(file);
+    }
+    if (capture != NULL && !write_capture(capture, &trace, profile->sample_freq_hz, capture_start)) {
+        fprintf(stderr, "Failed to write %s\n", capture);
+        sim_trace_free(&trace);
+        return 1;
+    }
+
+    sim_rx_config_t config = {
+        .profile = profile,
+        .sample_freq_hz = profile->sample_freq_hz,
+        .dsp = dsp,
+        .tolerance_pct = tolerance_pct,
+        .jitter_us = timing_jitter_us,
+    };
+    static sim_rx_result_t result;
+    sim_rx_run(&config, trace.samples, trace.count, &result);
+
+    char *sent = malloc(strlen(text) + 1);
+    if (sent == NULL) {
+        sim_trace_free(&trace);
+        return 1;
+    }
+    sim_sendable_text(text, sent);
+
+    printf("Profile:   %s%s, %lu Hz, dot %ld us\n", profile->name, dsp ? " + DSP" : "",
+           (unsigned long)profile->sample_freq_hz, (long)channel.dot_us);
+    printf("Trace:     %zu samples, %.3f s on air\n", trace.count, trace.on_air_s);
+    printf("Sent:      %s\n", sent);
+    printf("Received:  %s\n", result.text);
+    printf("CER:       %.4f\n", sim_char_error_rate(sent, result.text));
+    printf("Rate:      %.1f chars/s\n", trace.on_air_s > 0 ? trace.chars / trace.on_air_s : 0.0);
+    printf("Edges:     %lu, messages %lu, dot estimate %ld us\n", (unsigned long)result.edges,
+           (unsigned long)result.messages, (long)result.dot_us);
+    printf("Decode:    %.1f ns/sample (%.2f%% of real time)\n", result.ns_per_sample,
+           result.ns_per_sample * profile->sample_freq_hz / 1e7);
+
+    free(sent);
+    sim_trace_free(&trace);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Author: Noah Laforet
+ * Host receiver: the ADC path of morse_rx.c without ESP-IDF
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim_rx.h"
+#include "morse_decoder.h"
+#include "morse_slicer.h"
+#include "morse_dsp.h"
+
+#define TICK_SAMPLES        128     // ADC_FRAME_SAMPLES: the firmware ticks once per DMA frame
+#define SLICER_MAX_ON_MS    4000
+
+static void append(sim_rx_result_t *result, char c)
+{
+    if (result->length < SIM_RX_TEXT_MAX) {
+        result->text[result->length++] = c;
+        result->text[result->length] = '\0';
+    }
+}
+
+static void handle_event(const morse_event_t *event, void *ctx)
+{
+    sim_rx_result_t *result = ctx;
+
+    if (event->type == MORSE_EVENT_CHAR && (unsigned char)event->ch >= ' ') {
+        if (event->ch != ' ' || (result->length > 0 && result->text[result->length - 1] != ' ')) {
+            append(result, event->ch);
+        }
+    } else if (event->type == MORSE_EVENT_MESSAGE) {
+        result->messages++;
+        if (result->length > 0 && result->text[result->length - 1] != ' ') {
+            append(result, ' ');
+        }
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void sim_rx_run(const sim_rx_config_t *config, const uint16_t *samples, size_t count, sim_rx_result_t *result)
+{
+    uint32_t rate = config->sample_freq_hz;
+    memset(result, 0, sizeof(*result));
+
+    // Condition the samples exactly like condition_sample() in morse_rx.c
+    morse_dsp_t dsp;
+    if (config->dsp && count > 0) {
+        morse_dsp_init(&dsp, (uint32_t)(((uint64_t)config->profile->glitch_us * rate) / 2000000), samples[0]);
+    }
+    uint32_t dsp_delay = config->dsp ? morse_dsp_delay(&dsp) : 0;
+
+    // A fixed threshold starts decoding at once, as without CONFIG_MORSE_ADAPTIVE_THRESHOLD
+    int32_t calibration_ms = config->calibration_ms > 0 ? config->calibration_ms : SIM_RX_CALIBRATION_MS;
+    size_t calibration = config->threshold > 0 ? 0 : (size_t)(((uint64_t)calibration_ms * rate) / 1000);
+    if (calibration > count) {
+        calibration = count;
+    }
+    morse_slicer_cal_t cal;
+    morse_slicer_cal_reset(&cal);
+    for (size_t n = 0; n < calibration; n++) {
+        morse_slicer_cal_add(&cal, config->dsp ? morse_dsp_filter(&dsp, samples[n]) : samples[n]);
+    }
+
+    int32_t glitch_us = config->glitch_us > 0 ? config->glitch_us : SIM_RX_GLITCH_US;
+    uint32_t glitch_samples = (uint32_t)(((uint64_t)glitch_us * rate) / 1000000);
+    morse_slicer_t slicer;
+    if (config->threshold > 0) {
+        morse_slicer_init_fixed(&slicer, config->threshold, glitch_samples ? glitch_samples : 1);
+    } else {
+        morse_slicer_init(&slicer, &cal, config->min_swing > 0 ? config->min_swing : SIM_RX_MIN_SWING,
+                          glitch_samples ? glitch_samples : 1, (uint32_t)(((uint64_t)SLICER_MAX_ON_MS * rate) / 1000));
+    }
+
+    morse_decoder_t decoder;
+    morse_decoder_init(&decoder, config->profile, 0, handle_event, result);
+    if (config->dsp) {
+        morse_speed_use_ml_thresholds(&decoder.speed);
+    } else if (config->tolerance_pct > 0) {
+        // CONFIG_MORSE_TIMING_JITTER_US = 0: one sample period
+        int32_t jitter_us = config->jitter_us > 0 ? config->jitter_us : (int32_t)(1000000 / rate);
+        morse_speed_set_tolerance(&decoder.speed, config->tolerance_pct, jitter_us);
+    }
+
+    // The sample clock starts at zero after calibration, as on the ESP32
+    double start = now_ns();
+    int64_t sample_count = 0;
+    for (size_t n = calibration; n < count; n++, sample_count++) {
+        int32_t raw = config->dsp ? morse_dsp_filter(&dsp, samples[n]) : samples[n];
+        uint32_t edge_delay;
+        if (morse_slicer_feed(&slicer, raw, &edge_delay)) {
+            int64_t time_us = (sample_count - edge_delay - dsp_delay) * 1000000 / rate;
+            if (slicer.state) {
+                morse_decoder_rise(&decoder, time_us);
+            } else {
+                morse_decoder_fall(&decoder, time_us);
+            }
+            result->edges++;
+        }
+        if ((sample_count + 1) % TICK_SAMPLES == 0) {
+            morse_decoder_tick(&decoder, (sample_count + 1) * 1000000 / rate);
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    while (result->length > 0 && result->text[result->length - 1] == ' ') {
+        result->text[--result->length] = '\0';
+    }
+    result->dot_us = morse_speed_dot_us(&decoder.speed);
+    result->ns_per_sample = (count > calibration) ? elapsed / (double)(count - calibration) : 0.0;
+}
+
+double sim_char_error_rate(const char *sent, const char *received)
+{
+    size_t n = strlen(sent), m = strlen(received);
+    if (n == 0) {
+        return m ? 1.0 : 0.0;
+    }
+
+    size_t *row = malloc((m + 1) * sizeof(*row));
+    if (row == NULL) {
+        return 1.0;
+    }
+    for (size_t j = 0; j <= m; j++) {
+        row[j] = j;
+    }
+    for (size_t i = 1; i <= n; i++) {
+        size_t diagonal = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= m; j++) {
+            size_t above = row[j];
+            size_t best = diagonal + (sent[i - 1] != received[j - 1]);
+            if (above + 1 < best) {
+                best = above + 1;
+            }
+            if (row[j - 1] + 1 < best) {
+                best = row[j - 1] + 1;
+            }
+            row[j] = best;
+            diagonal = above;
+        }
+    }
+    double rate = (double)row[m] / (double)n;
+    free(row);
+    return rate;
+}
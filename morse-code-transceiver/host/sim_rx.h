@@ -0,0 +1,49 @@
+/*
+ * Author: Noah Laforet
+ * Host receiver: the ADC path of morse_rx.c without ESP-IDF
+ *
+ * Calibrates the slicer on the leading dark samples, then runs every sample
+ * through the optional matched filter, the slicer and the decoder with the
+ * same timestamps, glitch filter and tick spacing as the firmware, and
+ * collects the decoded text. The decode loop is timed for ns/sample.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "morse_profile.h"
+
+#define SIM_RX_CALIBRATION_MS       200     // CONFIG_MORSE_CALIBRATION_MS default
+#define SIM_RX_MIN_SWING            80      // CONFIG_MORSE_MIN_SWING default
+#define SIM_RX_GLITCH_US            100     // CONFIG_MORSE_GLITCH_US default
+#define SIM_RX_TOLERANCE_PCT        10      // CONFIG_MORSE_TIMING_TOLERANCE_PCT default
+#define SIM_RX_TEXT_MAX             4096
+
+typedef struct {
+    const morse_profile_t *profile;
+    uint32_t sample_freq_hz;
+    bool dsp;                   // CONFIG_MORSE_DSP: matched filter and ML thresholds
+    int32_t tolerance_pct;      // CONFIG_MORSE_TIMING_TOLERANCE_PCT (0 = midpoint thresholds)
+    int32_t jitter_us;          // CONFIG_MORSE_TIMING_JITTER_US (0 = one sample period)
+    // Slicer tuning; 0 leaves the firmware default
+    int32_t calibration_ms;     // CONFIG_MORSE_CALIBRATION_MS
+    int32_t min_swing;          // CONFIG_MORSE_MIN_SWING
+    int32_t glitch_us;          // CONFIG_MORSE_GLITCH_US
+    int32_t threshold;          // CONFIG_MORSE_LIGHT_THRESHOLD: fixed threshold, no calibration
+} sim_rx_config_t;
+
+typedef struct {
+    char text[SIM_RX_TEXT_MAX + 1];     // Decoded characters, messages joined by spaces
+    size_t length;
+    uint32_t edges;
+    uint32_t messages;
+    int32_t dot_us;             // Final speed estimate
+    double ns_per_sample;       // Slicer + decoder time, calibration excluded
+} sim_rx_result_t;
+
+void sim_rx_run(const sim_rx_config_t *config, const uint16_t *samples, size_t count, sim_rx_result_t *result);
+
+// Levenshtein distance over the length of `sent`
+double sim_char_error_rate(const char *sent, const char *received);
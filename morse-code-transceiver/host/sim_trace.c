@@ -0,0 +1,306 @@
+/*
+ * Author: Noah Laforet
+ * Photodiode sample trace simulator
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_trace.h"
+#include "morse_decoder.h"
+#include "morse_table.h"        // ITU tree, inverted into the encoder below
+
+#define TAIL_DOTS           40      // Idle after the message: the decoder needs two word gaps
+#define TAIL_MIN_MS         200
+#define RISE_TIME_CONSTANTS 2.197   // 10-90% rise of a first-order response, in time constants
+
+static uint8_t code_index[128];     // Character -> ITU tree index (0 = not sendable)
+
+static void build_code(void)
+{
+    static bool built = false;
+    if (built) {
+        return;
+    }
+    for (unsigned index = 1; index < MORSE_TREE_SIZE; index++) {
+        unsigned char c = (unsigned char)morse_trees[0][index];
+        if (c >= ' ' && c < 128 && code_index[c] == 0) {
+            code_index[c] = (uint8_t)index;
+        }
+    }
+    built = true;
+}
+
+/*---------------------------------------------------------------
+        Deterministic noise (xorshift64*, Box-Muller)
+---------------------------------------------------------------*/
+typedef struct {
+    uint64_t state;
+    bool has_spare;
+    double spare;
+} sim_rng_t;
+
+static void rng_init(sim_rng_t *rng, uint32_t seed)
+{
+    rng->state = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)seed << 1 | 1);
+    rng->has_spare = false;
+}
+
+static double rng_uniform(sim_rng_t *rng)
+{
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return (double)((rng->state * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double rng_gaussian(sim_rng_t *rng)
+{
+    if (rng->has_spare) {
+        rng->has_spare = false;
+        return rng->spare;
+    }
+    double u = rng_uniform(rng), v = rng_uniform(rng);
+    double r = sqrt(-2.0 * log(u > 0.0 ? u : 1e-300));
+    rng->spare = r * sin(2.0 * M_PI * v);
+    rng->has_spare = true;
+    return r * cos(2.0 * M_PI * v);
+}
+
+/*---------------------------------------------------------------
+        Channel Options
+---------------------------------------------------------------*/
+void sim_channel_defaults(sim_channel_t *channel, uint32_t sample_freq_hz, int32_t dot_us)
+{
+    *channel = (sim_channel_t){
+        .sample_freq_hz = sample_freq_hz,
+        .jitter_us = 5,              // pigpio DMA waves: a few microseconds
+        .rise_us = 50,
+        .off_level = 300,
+        .swing = 600,
+        .noise = 10,
+        .drift = 40,
+        .drift_period_ms = 10000,
+        .lead_ms = 300,             // Covers the receiver's 200 ms calibration
+        .seed = 1,
+    };
+    sim_channel_set_dot(channel, dot_us);
+}
+
+void sim_channel_set_dot(sim_channel_t *channel, int32_t dot_us)
+{
+    int64_t tail_ms = (int64_t)TAIL_DOTS * dot_us / 1000;
+    channel->dot_us = dot_us;
+    channel->tail_ms = (int32_t)(tail_ms > TAIL_MIN_MS ? tail_ms : TAIL_MIN_MS);
+}
+
+bool sim_channel_option(sim_channel_t *channel, const char *name, const char *value)
+{
+    static const struct {
+        const char *name;
+        size_t offset;
+    } options[] = {
+        {"--jitter-us", offsetof(sim_channel_t, jitter_us)},
+        {"--rise-us", offsetof(sim_channel_t, rise_us)},
+        {"--off-level", offsetof(sim_channel_t, off_level)},
+        {"--swing", offsetof(sim_channel_t, swing)},
+        {"--noise", offsetof(sim_channel_t, noise)},
+        {"--drift", offsetof(sim_channel_t, drift)},
+        {"--drift-period-ms", offsetof(sim_channel_t, drift_period_ms)},
+        {"--seed", offsetof(sim_channel_t, seed)},
+    };
+
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+        if (strcmp(name, options[i].name) == 0) {
+            *(int32_t *)((char *)channel + options[i].offset) = (int32_t)strtol(value, NULL, 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *sim_channel_usage(void)
+{
+    return "  --jitter-us N        edge timing jitter, standard deviation (default 5)\n"
+           "  --rise-us N          photodiode 10-90% rise/fall time (default 50)\n"
+           "  --off-level N        ADC counts with the LED off (default 300)\n"
+           "  --swing N            ADC counts the LED adds (default 600)\n"
+           "  --noise N            Gaussian noise in counts, standard deviation (default 10)\n"
+           "  --drift N            ambient drift amplitude in counts (default 40)\n"
+           "  --drift-period-ms N  period of the ambient drift (default 10000)\n"
+           "  --seed N             noise and jitter seed (default 1)\n";
+}
+
+/*---------------------------------------------------------------
+        Keying (morse_schedule.py timing model)
+---------------------------------------------------------------*/
+size_t sim_sendable_text(const char *text, char *out)
+{
+    build_code();
+
+    size_t length = 0;
+    for (const char *p = text; *p; p++) {
+        unsigned char c = (unsigned char)toupper((unsigned char)*p);
+        if (c == ' ' || c == '\t' || c == '\n') {
+            if (length > 0 && out[length - 1] != ' ') {
+                out[length++] = ' ';
+            }
+        } else if (c < 128 && code_index[c] != 0) {
+            out[length++] = (char)c;
+        }
+    }
+    while (length > 0 && out[length - 1] == ' ') {
+        length--;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Calls pulse(start, end) in dot units for every ON run; returns the message length in units
+static uint32_t key_text(const char *sendable, void (*pulse)(uint32_t start, uint32_t end, void *ctx), void *ctx)
+{
+    char pattern[MORSE_PATTERN_MAX];
+    uint32_t units = 0;
+
+    for (const char *p = sendable; *p; p++) {
+        if (*p == ' ') {
+            units += 7 - 3;  // A letter gap already follows the previous character
+            continue;
+        }
+        for (const char *symbol = morse_index_pattern(code_index[(unsigned char)*p], pattern); *symbol; symbol++) {
+            uint32_t length = (*symbol == '.') ? 1 : 3;
+            if (pulse) {
+                pulse(units, units + length, ctx);
+            }
+            units += length + 1;
+        }
+        units += 3 - 1;
+    }
+    return units;
+}
+
+uint32_t sim_message_units(const char *text)
+{
+    char *sendable = malloc(strlen(text) + 1);
+    if (sendable == NULL) {
+        return 0;
+    }
+    sim_sendable_text(text, sendable);
+    uint32_t units = key_text(sendable, NULL, NULL);
+    free(sendable);
+    return units;
+}
+
+/*---------------------------------------------------------------
+        Trace Generation
+---------------------------------------------------------------*/
+typedef struct {
+    double on_us;
+    double off_us;
+} sim_pulse_t;
+
+typedef struct {
+    const sim_channel_t *channel;
+    sim_rng_t *rng;
+    sim_pulse_t *pulses;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} pulse_list_t;
+
+static void add_pulse(uint32_t start, uint32_t end, void *ctx)
+{
+    pulse_list_t *list = ctx;
+    const sim_channel_t *channel = list->channel;
+
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? 2 * list->capacity : 256;
+        sim_pulse_t *pulses = realloc(list->pulses, capacity * sizeof(*pulses));
+        if (pulses == NULL) {
+            list->failed = true;
+            return;
+        }
+        list->pulses = pulses;
+        list->capacity = capacity;
+    }
+
+    double lead_us = channel->lead_ms * 1000.0;
+    double on = lead_us + (double)start * channel->dot_us + channel->jitter_us * rng_gaussian(list->rng);
+    double off = lead_us + (double)end * channel->dot_us + channel->jitter_us * rng_gaussian(list->rng);
+
+    // Jitter can't reorder edges
+    double previous_off = list->count ? list->pulses[list->count - 1].off_us : 0.0;
+    if (on < previous_off) {
+        on = previous_off;
+    }
+    if (off < on) {
+        off = on;
+    }
+    list->pulses[list->count++] = (sim_pulse_t){on, off};
+}
+
+bool sim_trace_generate(const sim_channel_t *channel, const char *text, sim_trace_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+
+    char *sendable = malloc(strlen(text) + 1);
+    if (sendable == NULL) {
+        return false;
+    }
+    trace->chars = sim_sendable_text(text, sendable);
+
+    sim_rng_t rng;
+    rng_init(&rng, channel->seed);
+    pulse_list_t list = {.channel = channel, .rng = &rng};
+    uint32_t units = key_text(sendable, add_pulse, &list);
+    free(sendable);
+    if (list.failed) {
+        free(list.pulses);
+        return false;
+    }
+
+    double sample_us = 1e6 / channel->sample_freq_hz;
+    double message_us = (double)units * channel->dot_us;
+    double total_us = (channel->lead_ms + channel->tail_ms) * 1000.0 + message_us;
+    trace->on_air_s = message_us / 1e6;
+    trace->count = (size_t)(total_us / sample_us);
+    trace->samples = malloc(trace->count * sizeof(*trace->samples));
+    if (trace->samples == NULL) {
+        free(list.pulses);
+        return false;
+    }
+
+    double alpha = 1.0;
+    if (channel->rise_us > 0) {
+        alpha = 1.0 - exp(-sample_us * RISE_TIME_CONSTANTS / channel->rise_us);
+    }
+    double drift_w = channel->drift_period_ms > 0 ? 2.0 * M_PI / (channel->drift_period_ms * 1000.0) : 0.0;
+
+    double light = 0.0;
+    size_t next = 0;
+    for (size_t n = 0; n < trace->count; n++) {
+        double t = n * sample_us;
+        while (next < list.count && t >= list.pulses[next].off_us) {
+            next++;
+        }
+        bool on = next < list.count && t >= list.pulses[next].on_us;
+        light += ((on ? 1.0 : 0.0) - light) * alpha;
+
+        double value = channel->off_level + channel->drift * sin(drift_w * t) + channel->swing * light +
+                       channel->noise * rng_gaussian(&rng);
+        long raw = lround(value);
+        trace->samples[n] = (uint16_t)(raw < 0 ? 0 : raw > SIM_ADC_MAX ? SIM_ADC_MAX : raw);
+    }
+
+    free(list.pulses);
+    return true;
+}
+
+void sim_trace_free(sim_trace_t *trace)
+{
+    free(trace->samples);
+    trace->samples = NULL;
+    trace->count = 0;
+}
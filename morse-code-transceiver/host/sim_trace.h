@@ -0,0 +1,61 @@
+/*
+ * Author: Noah Laforet
+ * Photodiode sample trace simulator
+ *
+ * Turns text into the raw ADC samples the receiver would see: the message is
+ * keyed with the transmitter's timing model (morse_schedule.py: dot 1, dash
+ * 3, symbol gap 1, letter gap 3, word gap 7 units), each edge is moved by
+ * Gaussian timing jitter, the light goes through a first-order photodiode
+ * response, and ambient drift and Gaussian noise are added on top. The
+ * pseudo-random source is seeded, so a trace is reproducible.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SIM_ADC_MAX         4095
+
+typedef struct {
+    uint32_t sample_freq_hz;
+    int32_t dot_us;
+    int32_t jitter_us;          // Edge timing jitter, standard deviation
+    int32_t rise_us;            // Photodiode 10-90% rise (and fall) time
+    int32_t off_level;          // ADC counts with the LED off
+    int32_t swing;              // ADC counts the LED adds
+    int32_t noise;              // Gaussian noise, standard deviation in counts
+    int32_t drift;              // Ambient drift amplitude in counts (slow sine)
+    int32_t drift_period_ms;
+    int32_t lead_ms;            // Dark time before the message (calibration)
+    int32_t tail_ms;            // Dark time after it (end of message)
+    uint32_t seed;
+} sim_channel_t;
+
+typedef struct {
+    uint16_t *samples;
+    size_t count;
+    size_t chars;               // Characters keyed (spaces included)
+    double on_air_s;            // Message time, lead and tail excluded
+} sim_trace_t;
+
+// Bench defaults: a clean channel at the profile's sample rate and dot
+void sim_channel_defaults(sim_channel_t *channel, uint32_t sample_freq_hz, int32_t dot_us);
+
+// Change the keying speed (and the idle tail the end of message needs)
+void sim_channel_set_dot(sim_channel_t *channel, int32_t dot_us);
+
+// "--name value" option shared by the tools; false if name isn't a channel option
+bool sim_channel_option(sim_channel_t *channel, const char *name, const char *value);
+const char *sim_channel_usage(void);
+
+// Upper-case, drop what can't be keyed and collapse spaces: what a perfect
+// receiver would print. Returns the length written to out (size >= strlen(text) + 1).
+size_t sim_sendable_text(const char *text, char *out);
+
+// Message time in dot units, as keyed by sim_trace_generate()
+uint32_t sim_message_units(const char *text);
+
+bool sim_trace_generate(const sim_channel_t *channel, const char *text, sim_trace_t *trace);
+void sim_trace_free(sim_trace_t *trace);
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Author: Noah Laforet
+Corpus-tuned Morse code table generator
+
+Counts how often each sendable character occurs in a sample of real payloads
+and gives the cheapest dot/dash patterns to the most frequent characters.
+Cost is on-air time in dot units: 1 per dot, 3 per dash, 1 between symbols and
+the 3-unit letter gap. Letters are delimited by gaps, so the code does not
+need to be prefix-free, and sorting patterns by cost against characters by
+frequency is then the optimal assignment (what a Huffman code is for a code
+without delimiters).
+
+Every printable character of ITU MORSE_CODE gets a pattern, seen in the
+corpus or not, and the prosigns keep their ITU patterns so frames and data
+bursts are recognised whatever table is active.
+
+Usage: python3 gen_code_table.py <corpus.txt> <name> <output.py>
+"""
+
+import collections
+import itertools
+import os
+import sys
+
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "transmitter", "src"))
+from morse_code import MORSE_CODE  # noqa: E402
+
+MAX_LENGTH = 6          # Keeps the receiver's lookup tree at its current depth
+LETTER_GAP_UNITS = 3
+WORD_GAP_UNITS = 7
+
+
+def pattern_units(pattern):
+    symbols = sum(1 if symbol == '.' else 3 for symbol in pattern)
+    return symbols + (len(pattern) - 1) + LETTER_GAP_UNITS
+
+
+def corpus_units(text, code):
+    """Average on-air units per character of `text` sent with `code`, spaces included."""
+    units = 0
+    count = 0
+    for char in text:
+        if char == ' ':
+            units += WORD_GAP_UNITS - LETTER_GAP_UNITS
+        elif char in code:
+            units += pattern_units(code[char])
+        else:
+            continue
+        count += 1
+    return units / count if count else 0.0
+
+
+def build_code(text):
+    alphabet = [char for char in MORSE_CODE if char.isprintable() and char != ' ']
+    reserved = {code for char, code in MORSE_CODE.items() if not char.isprintable()}
+
+    counts = collections.Counter(char for char in text if char in alphabet)
+    chars = sorted(alphabet, key=lambda char: (-counts[char], pattern_units(MORSE_CODE[char]), char))
+
+    patterns = [''.join(p) for length in range(1, MAX_LENGTH + 1) for p in itertools.product('.-', repeat=length)]
+    patterns = sorted((p for p in patterns if p not in reserved), key=lambda p: (pattern_units(p), len(p), p))
+
+    code = dict(zip(chars, patterns))
+    code[' '] = MORSE_CODE[' ']
+    code.update({char: pattern for char, pattern in MORSE_CODE.items() if not char.isprintable()})
+    return code, counts
+
+
+def render_module(source, name, text, code, counts):
+    itu = corpus_units(text, MORSE_CODE)
+    tuned = corpus_units(text, code)
+    lines = [
+        '"""',
+        f"Generated by tools/gen_code_table.py from {source} - do not edit.",
+        "",
+        f"{name} code table: the cheapest patterns go to the most frequent characters",
+        "of the sample corpus. Prosigns keep their ITU patterns.",
+        f"Corpus: {sum(counts.values())} characters, {itu:.2f} units/char with ITU Morse,",
+        f"{tuned:.2f} with this table ({100 * (tuned - itu) / itu:+.0f}%). Comments are corpus counts.",
+        '"""',
+        "",
+        "CODE = {",
+    ]
+    for char, pattern in code.items():
+        entry = f"    {char!r}: {pattern!r},"
+        if char == ' ':
+            comment = "# Word gap"
+        else:
+            comment = f"# {counts[char]}" if char.isprintable() else "# Prosign"
+        lines.append(f"{entry:<22}{comment}")
+    lines += ["}", ""]
+    return "\n".join(lines), itu, tuned
+
+
+def main():
+    if len(sys.argv) != 4:
+        print("Usage: python3 gen_code_table.py <corpus.txt> <name> <output.py>")
+        sys.exit(1)
+
+    corpus, name, output = sys.argv[1:]
+    with open(corpus) as f:
+        text = ' '.join(f.read().upper().split())
+
+    code, counts = build_code(text)
+    module, itu, tuned = render_module(os.path.basename(corpus), name, text, code, counts)
+    with open(output, "w") as f:
+        f.write(module)
+    print(f"{name}: {itu:.2f} -> {tuned:.2f} units/char ({100 * (tuned - itu) / itu:+.0f}%)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Author: Noah Laforet
+Morse lookup tree generator
+
+Reads CODE_TABLES from transmitter/src/morse_code.py and writes morse_table.h,
+one heap-ordered lookup tree per code table for the receiver firmware. The
+receiver walks the tree while symbols arrive (root = 0, dot -> 2i+1,
+dash -> 2i+2), so a finished letter resolves to its character with a single
+table load. All trees share the depth of the deepest table.
+
+Usage: python3 gen_morse_table.py <morse_code.py> <morse_table.h>
+"""
+
+import importlib.util
+import os
+import sys
+
+
+def load_code_tables(path):
+    sys.dont_write_bytecode = True  # Runs from the build: keep the source tree clean
+    sys.path.insert(0, os.path.dirname(os.path.abspath(path)))  # Generated tables sit next to it
+    spec = importlib.util.spec_from_file_location("morse_code", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.CODE_TABLES, module.TABLE_NAMES
+
+
+def tree_index(code):
+    index = 0
+    for symbol in code:
+        index = 2 * index + (1 if symbol == '.' else 2)
+    return index
+
+
+def patterns(morse_code):
+    # Entries like ' ': '/' are word separators, not dot/dash patterns
+    return {char: code for char, code in morse_code.items()
+            if code and set(code) <= {'.', '-'}}
+
+
+def build_tree(morse_code, depth):
+    codes = patterns(morse_code)
+    tree = [None] * (2 ** (depth + 1) - 1)
+
+    for char, code in codes.items():
+        index = tree_index(code)
+        if tree[index] is not None:
+            raise ValueError(f"'{char}' and '{tree[index][0]}' share the code '{code}'")
+        tree[index] = (char, code)
+
+    return tree
+
+
+def c_char(char):
+    if char == "'" or char == '\\':
+        return "'\\" + char + "'"
+    if char.isprintable():
+        return "'" + char + "'"
+    return "'\\x%02x'" % ord(char)
+
+
+def render_header(source, depth, names, trees):
+    lines = [
+        "/*",
+        f" * Generated by tools/gen_morse_table.py from {source} - do not edit.",
+        " *",
+        " * Heap-ordered Morse lookup trees, one per code table: root = 0,",
+        " * dot -> 2i+1, dash -> 2i+2. Entries holding '\\0' are patterns with no",
+        " * assigned character. Everything here is const, so it stays in flash",
+        " * (.flash.rodata) and costs no RAM.",
+        " */",
+        "",
+        "#pragma once",
+        "",
+        f"#define MORSE_TREE_DEPTH    {depth}",
+        f"#define MORSE_TREE_SIZE     {len(trees[0])}",
+        f"#define MORSE_TABLE_COUNT   {len(trees)}",
+        "",
+        "static const char *const morse_table_names[MORSE_TABLE_COUNT] = {",
+    ]
+    lines += [f'    "{name}",' for name in names]
+    lines += [
+        "};",
+        "",
+        "static const char morse_trees[MORSE_TABLE_COUNT][MORSE_TREE_SIZE] = {",
+    ]
+    for table, (name, tree) in enumerate(zip(names, trees)):
+        lines.append(f"    [{table}] = {{  // {name}")
+        for index, entry in enumerate(tree):
+            if entry is None:
+                continue
+            char, code = entry
+            entry = f"        [{index:3}] = {c_char(char)},"
+            lines.append(f"{entry:<28}// {code}")
+        lines.append("    },")
+    lines += ["};", ""]
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("Usage: python3 gen_morse_table.py <morse_code.py> <morse_table.h>")
+        sys.exit(1)
+
+    source, output = sys.argv[1], sys.argv[2]
+    tables, names = load_code_tables(source)
+    depth = max(len(code) for table in tables for code in patterns(table).values())
+    trees = [build_tree(table, depth) for table in tables]
+    header = render_header(os.path.basename(source), depth, names, trees)
+
+    with open(output, "w") as f:
+        f.write(header)
+
+
+if __name__ == "__main__":
+    main()
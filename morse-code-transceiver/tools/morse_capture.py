@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Author: Noah Laforet
+Record the raw ADC capture of a receiver built with CONFIG_MORSE_CAPTURE
+
+The receiver sends its capture blocks (morse_capture.h) on the console it
+logs to. This reads the serial port, keeps every block whose sync bytes and
+CRC check out and writes them, and nothing else, to the output file for
+host/morse_replay. The log text in between goes to stderr as it arrives.
+"-" as the port reads a saved console stream from stdin instead.
+
+Usage: python3 morse_capture.py [--seconds N] [--baud N] <port> <out.bin>
+
+Stop it with Ctrl-C, or after --seconds. A summary of the blocks per
+channel, the blocks the receiver reported lost and the data rate is printed
+at the end.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "transmitter", "src"))
+from morse_console import CONSOLE_BAUD, open_console  # noqa: E402
+
+SYNC = b"MC"
+VERSION = 1
+HEADER = struct.Struct("<2sBBHHIIH")    # sync, version, channel, N, decimation, rate, first sample, lost
+BLOCK_SAMPLES = 256
+CRC_BYTES = 2
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), as morse_crc16() in the receiver."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class BlockScanner:
+    """Splits a console byte stream into capture blocks and everything else."""
+
+    def __init__(self, out):
+        self.out = out
+        self.pending = b""
+        self.blocks = {}            # channel -> [blocks, lost, samples, rate]
+        self.block_bytes = 0
+
+    def feed(self, data):
+        """Add bytes; returns the console text found, for echoing."""
+        buf = self.pending + data
+        text = bytearray()
+        i = 0
+        while i < len(buf):
+            start = buf.find(SYNC, i)
+            if start < 0:
+                # A trailing "M" may be the start of the next block
+                keep = len(buf) - 1 if buf.endswith(SYNC[:1]) else len(buf)
+                text += buf[i:keep]
+                i = keep
+                break
+            text += buf[i:start]
+            length = self._block_length(buf, start)
+            if length is None:
+                i = start       # Not all here yet
+                break
+            if length == 0:
+                text += buf[start:start + 1]
+                i = start + 1
+                continue
+            self._keep(buf[start:start + length])
+            i = start + length
+        self.pending = buf[i:]
+        return bytes(text)
+
+    def _block_length(self, buf, start):
+        """Length of a valid block at start, 0 if there is none, None if more bytes are needed."""
+        if len(buf) - start < HEADER.size:
+            return None
+        _, version, _, count, _, _, _, _ = HEADER.unpack_from(buf, start)
+        if version != VERSION or count > BLOCK_SAMPLES or count % 2:
+            return 0
+        length = HEADER.size + count * 3 // 2
+        if len(buf) - start < length + CRC_BYTES:
+            return None
+        (crc,) = struct.unpack_from("<H", buf, start + length)
+        if crc != crc16(buf[start:start + length]):
+            return 0
+        return length + CRC_BYTES
+
+    def _keep(self, block):
+        _, _, channel, count, _, rate, _, lost = HEADER.unpack_from(block)
+        stats = self.blocks.setdefault(channel, [0, 0, 0, rate])
+        stats[0] += 1
+        stats[1] += lost
+        stats[2] += count
+        self.out.write(block)
+        self.block_bytes += len(block)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record the receiver's raw ADC capture blocks for morse_replay")
+    parser.add_argument("port", help="receiver's serial port, e.g. /dev/ttyACM0, or - for stdin")
+    parser.add_argument("out", help="capture file to write")
+    parser.add_argument("--seconds", type=float, help="stop after this long (default: Ctrl-C)")
+    parser.add_argument("--baud", type=int, default=CONSOLE_BAUD, help="UART console rate (default %(default)d)")
+    args = parser.parse_args()
+
+    if args.port == "-":
+        def read():
+            return sys.stdin.buffer.read1(65536)
+    else:
+        try:
+            serial_port = open_console(args.port, args.baud, "morse_capture.py")
+        except RuntimeError as e:
+            sys.exit(str(e))
+
+        def read():
+            return serial_port.read(max(1, serial_port.in_waiting))
+
+    start = time.monotonic()
+    with open(args.out, "wb") as out:
+        scanner = BlockScanner(out)
+        try:
+            while args.seconds is None or time.monotonic() - start < args.seconds:
+                data = read()
+                if not data and args.port == "-":
+                    break
+                text = scanner.feed(data)
+                if text:
+                    sys.stderr.write(text.decode("ascii", errors="replace"))
+                    sys.stderr.flush()
+        except KeyboardInterrupt:
+            pass
+    elapsed = time.monotonic() - start
+
+    print(f"\n{args.out}: {scanner.block_bytes} bytes of blocks in {elapsed:.1f} s "
+          f"({scanner.block_bytes / max(elapsed, 1e-6) / 1000:.1f} kB/s)", file=sys.stderr)
+    for channel, (blocks, lost, samples, rate) in sorted(scanner.blocks.items()):
+        print(f"  ch{channel}: {blocks} blocks, {samples / rate:.2f} s at {rate} Hz, "
+              f"{lost} reported lost by the receiver", file=sys.stderr)
+    if not scanner.blocks:
+        print("  no capture blocks: is the receiver built with CONFIG_MORSE_CAPTURE?", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Author: Noah Laforet
+Static memory budget of the Morse decoder
+
+Reads the GNU ld map file of a receiver build and adds up, for every object
+of the morse_decoder component and the app's main, the bytes it puts in each
+ESP32-C3 memory region:
+
+  data    initialised RAM (.dram0.data); its initial values are in flash too
+  bss     zeroed RAM (.dram0.bss, .noinit)
+  iram    code copied to internal SRAM (.iram0.*): ISRs and IRAM_ATTR
+  code    code executed from flash (.flash.text)
+  rodata  const data read from flash (.flash.rodata, ...): lookup tables, strings
+
+On the C3, IRAM and DRAM are the same SRAM, so RAM = data + bss + iram.
+Task stacks and driver buffers are allocated at run time and not included;
+the start-up log and `heap_caps_print_heap_info()` cover those.
+
+With --build, every configuration fragment in tools/size_configs (or the ones
+named) is built on top of the app's sdkconfig.defaults with idf.py, each in
+its own build directory, and one summary line is printed per configuration.
+
+Usage: python3 size_report.py <app.map> [<app.map> ...]
+       python3 size_report.py --build <app dir> [config ...]
+"""
+
+import collections
+import glob
+import os
+import re
+import subprocess
+import sys
+
+CONFIG_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "size_configs")
+COMPONENTS = ("morse_decoder", "main")
+REGIONS = ("data", "bss", "iram", "code", "rodata")
+
+# esp-idf/morse_decoder/libmorse_decoder.a(morse_rx.c.obj)
+ARCHIVE_MEMBER = re.compile(r"lib([^/\\]+)\.a\(([^)]+)\)$")
+
+
+def region_of(section):
+    if section.startswith(".iram0."):
+        return "iram"
+    if section.startswith(".dram0.bss") or section == ".noinit":
+        return "bss"
+    if section.startswith(".dram0."):
+        return "data"
+    if section.startswith(".flash.text"):
+        return "code"
+    if section.startswith(".flash."):
+        return "rodata"
+    return None     # RTC memory, debug info, discarded sections
+
+
+def parse_map(path):
+    """Returns {(component, object): Counter(region -> bytes)} for every archive member."""
+    usage = collections.defaultdict(collections.Counter)
+    in_map = False
+    section = None
+    pending = None      # Input section whose address and size wrapped onto the next line
+
+    with open(path, errors="replace") as f:
+        for line in f:
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            line = line.rstrip("\n")
+            fields = line.split()
+            if not fields:
+                continue
+
+            # Output sections start in column 0, input sections in column 1
+            if not line[0].isspace():
+                section, pending = fields[0], None
+                continue
+            if line[1] != " ":
+                if len(fields) == 1:
+                    pending = fields[0]
+                    continue
+                rest = fields[1:]
+            elif pending and fields[0].startswith("0x"):
+                rest = fields
+            else:
+                continue
+            pending = None
+
+            if len(rest) < 3 or not rest[1].startswith("0x"):
+                continue    # *fill*, or a symbol address
+            region = region_of(section)
+            member = ARCHIVE_MEMBER.search(" ".join(rest[2:]))
+            if region is None or member is None:
+                continue
+            usage[member.groups()][region] += int(rest[1], 16)
+    return usage
+
+
+def print_map_report(path, usage):
+    print(path)
+    print(f"{'object':<28}" + "".join(f"{region:>9}" for region in REGIONS))
+
+    image = collections.Counter()
+    for counter in usage.values():
+        image.update(counter)
+
+    for component in COMPONENTS:
+        objects = sorted((obj, counter) for (comp, obj), counter in usage.items() if comp == component)
+        if not objects:
+            continue
+        total = collections.Counter()
+        for obj, counter in objects:
+            total.update(counter)
+            print(f"  {obj:<26}" + "".join(f"{counter[region]:>9}" for region in REGIONS))
+        print(f"{component + ' total':<28}" + "".join(f"{total[region]:>9}" for region in REGIONS))
+    print(f"{'whole image':<28}" + "".join(f"{image[region]:>9}" for region in REGIONS))
+    print()
+
+
+def component_totals(usage, component):
+    total = collections.Counter()
+    for (comp, _), counter in usage.items():
+        if comp == component:
+            total.update(counter)
+    return total
+
+
+def build_config(app, config):
+    fragment = os.path.join(CONFIG_DIR, config + ".cfg")
+    if not os.path.isfile(fragment):
+        raise SystemExit(f"No configuration fragment {fragment}")
+
+    build_dir = os.path.join(app, "build-size", config)
+    defaults = ";".join((os.path.join(app, "sdkconfig.defaults"), fragment))
+    command = ["idf.py", "-C", app, "-B", build_dir,
+               "-D", f"SDKCONFIG={os.path.join(build_dir, 'sdkconfig')}",
+               "-D", f"SDKCONFIG_DEFAULTS={defaults}", "build"]
+    print(f"Building {config} ...", file=sys.stderr)
+    try:
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    except FileNotFoundError:
+        raise SystemExit("idf.py not found; source $IDF_PATH/export.sh first")
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout)
+        raise SystemExit(f"{config}: idf.py build failed")
+
+    maps = glob.glob(os.path.join(build_dir, "*.map"))
+    if len(maps) != 1:
+        raise SystemExit(f"{config}: expected one map file in {build_dir}")
+    return maps[0]
+
+
+def build_report(app, configs):
+    app = os.path.abspath(app)
+    if not configs:
+        configs = sorted(os.path.splitext(name)[0] for name in os.listdir(CONFIG_DIR) if name.endswith(".cfg"))
+
+    rows = []
+    for config in configs:
+        path = build_config(app, config)
+        usage = parse_map(path)
+        print_map_report(os.path.relpath(path), usage)
+        rows.append((config, component_totals(usage, "morse_decoder")))
+
+    print(f"morse_decoder per configuration ({os.path.basename(app)})")
+    print(f"{'config':<14}{'RAM':>9}{'IRAM':>9}{'flash':>9}   (RAM = data + bss, flash = code + rodata + data)")
+    for config, total in rows:
+        ram = total["data"] + total["bss"]
+        flash = total["code"] + total["rodata"] + total["data"]
+        print(f"{config:<14}{ram:>9}{total['iram']:>9}{flash:>9}")
+
+
+def main():
+    if len(sys.argv) >= 3 and sys.argv[1] == "--build":
+        build_report(sys.argv[2], sys.argv[3:])
+    elif len(sys.argv) >= 2 and not sys.argv[1].startswith("-"):
+        for path in sys.argv[1:]:
+            print_map_report(path, parse_map(path))
+    else:
+        print("Usage: python3 size_report.py <app.map> [<app.map> ...]\n"
+              "       python3 size_report.py --build <app dir> [config ...]")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,218 @@
+"""
+Author: Noah Laforet
+Closed-loop link rate (autobaud)
+
+The receiver prints a line on its console for every frame it parses
+(CONFIG_MORSE_LINK_REPORT):
+
+    @link <channel> <seq> <status> <dot_us> <corrected>
+
+so with its USB serial port plugged into the Pi the transmitter can read back
+which of its frames got through. To negotiate a rate it sends a few short
+probe frames at each dot length of a ladder, fastest first, and settles on
+the first one whose probes come back with an acceptable frame error rate.
+Failed rates are the fast, cheap ones, so the search costs little more than
+one probe at the rate it picks. Any firmware profile can be matched this
+way: the adaptive speed estimator on the receiver follows each new rate.
+
+Afterwards every frame sent is checked against the reports. When more of
+the last WINDOW_FRAMES frames are lost than the error rate allows, the
+search starts over one step slower, and after `reprobe_s` without errors one step
+faster is tried, so the rate tracks the optical conditions.
+"""
+
+import collections
+import re
+import sys
+import threading
+import time
+
+from morse_console import CONSOLE_BAUD, open_console
+from morse_schedule import WORD_SPACE_UNITS
+
+LINK_REPORT = re.compile(r"@link (\d+) ([0-9A-F]{2}) (\w+) (\d+) (\d+)")
+
+# Dot lengths tried, fastest first (ms); the slowest is the standard profile's dot
+DOT_LADDER_MS = (1, 1.5, 2, 3, 5, 7, 10, 15, 20, 30, 50, 100, 200)
+GPIO_MIN_DOT_MS = 10            # RPi.GPIO edge jitter; the pigpio backend can use the whole ladder
+
+PROBE_PAYLOAD = "PROBE"
+PROBE_FRAMES = 3                # Frames per rate tried
+MAX_FER = 0.1                   # Frame error rate the link may run at
+WINDOW_FRAMES = 10              # Frames the running error rate is taken over
+REPROBE_S = 60                  # Clean running time before trying one step faster
+REPORT_WAIT_S = 1.0             # Log task and serial latency after the last frame
+
+
+def report_timeout(dot):
+    """Seconds after a frame is keyed by which its report is due. Also long enough
+    for the receiver to end the message (two word gaps) before a new rate starts."""
+    return max(REPORT_WAIT_S, 2 * WORD_SPACE_UNITS * dot)
+
+
+def dot_ladder(backend):
+    """Dot lengths in seconds, fastest first, that the backend can key."""
+    min_ms = 0 if backend == "pigpio" else GPIO_MIN_DOT_MS
+    return [ms / 1000 for ms in DOT_LADDER_MS if ms >= min_ms]
+
+
+class LinkMonitor:
+    """Reads @link reports from the receiver's serial console on a thread."""
+
+    def __init__(self, port, baud=CONSOLE_BAUD):
+        self.port = open_console(port, baud, "--autobaud")
+
+        self._lock = threading.Lock()
+        self._delivered = {}        # seq -> True once reported OK since expect()
+        self.reports = 0
+        self.dot_us = None          # Receiver's dot estimate in the last report
+        self._running = True
+        self._thread = threading.Thread(target=self._reader, daemon=True)
+        self._thread.start()
+
+    def _reader(self):
+        while self._running:
+            try:
+                line = self.port.readline().decode("ascii", errors="replace")
+            except Exception as e:      # Port unplugged: stop reporting, the link looks dead
+                print(f"[autobaud] serial port lost: {e}", file=sys.stderr, flush=True)
+                return
+            match = LINK_REPORT.search(line)
+            if not match:
+                continue
+            seq = int(match.group(2), 16)
+            with self._lock:
+                # A corrupted frame may report any seq; only a good one can be trusted
+                if match.group(3) == "ok":
+                    self._delivered[seq] = True
+                self.reports += 1
+                self.dot_us = int(match.group(4))
+
+    def expect(self, seqs):
+        """Forget stale reports for seqs about to be reused."""
+        with self._lock:
+            for seq in seqs:
+                self._delivered.pop(seq, None)
+
+    def delivered(self, seqs):
+        with self._lock:
+            return sum(1 for seq in seqs if self._delivered.get(seq))
+
+    def wait(self, seqs, timeout):
+        """Wait until every seq is reported OK or timeout runs out; returns how many were."""
+        deadline = time.monotonic() + timeout
+        while True:
+            got = self.delivered(seqs)
+            if got == len(seqs) or time.monotonic() >= deadline:
+                return got
+            time.sleep(0.02)
+
+    def close(self):
+        self._running = False
+        self._thread.join(timeout=1)
+        self.port.close()
+
+
+class LinkRate:
+    """Picks the keying rate from the receiver's reports and keeps it up to date."""
+
+    def __init__(self, monitor, framer, key, ladder, max_fer=MAX_FER, reprobe_s=REPROBE_S):
+        # key(text, dot_s) keys already framed text and returns when it is off the air
+        self.monitor = monitor
+        self.framer = framer
+        self.key = key
+        self.ladder = ladder
+        self.max_fer = max_fer
+        self.reprobe_s = reprobe_s
+        self.index = None
+        self.changed = time.monotonic()
+        self.window = collections.deque(maxlen=WINDOW_FRAMES)     # True per frame delivered
+        self.pending = collections.deque()                        # (seqs, deadline) not yet checked
+        self.frames_sent = 0
+        self.frames_ok = 0
+
+    @property
+    def dot(self):
+        return self.ladder[self.index]
+
+    def frame(self, text):
+        """Frame text with the next sequence numbers; returns (framed text, seqs)."""
+        first = self.framer.seq
+        framed = self.framer.frame(text)
+        seqs = [(first + i) & 0xFF for i in range((self.framer.seq - first) & 0xFF)]
+        self.monitor.expect(seqs)
+        return framed, seqs
+
+    def probe(self, index):
+        dot = self.ladder[index]
+        seqs = []
+        for _ in range(PROBE_FRAMES):
+            framed, frame_seqs = self.frame(PROBE_PAYLOAD)
+            self.key(framed, dot)
+            seqs += frame_seqs
+        got = self.monitor.wait(seqs, report_timeout(dot))
+        fer = 1 - got / len(seqs)
+        print(f"[autobaud] dot {dot * 1000:g} ms: {got}/{len(seqs)} probe frames OK", file=sys.stderr, flush=True)
+        return fer <= self.max_fer
+
+    def negotiate(self, start=0):
+        """Settle on the fastest ladder rate from `start` down that gets through."""
+        for index in range(start, len(self.ladder)):
+            if self.probe(index):
+                self.index = index
+                self.changed = time.monotonic()
+                self.window.clear()
+                print(f"[autobaud] link at {self.dot * 1000:g} ms dots "
+                      f"(receiver estimates {self.monitor.dot_us} us)", file=sys.stderr, flush=True)
+                return self.dot
+        raise RuntimeError("No rate on the ladder got through; check the link and the serial port")
+
+    def send(self, line):
+        """Frame and key one line at the current rate, then react to the reports so far."""
+        framed, seqs = self.frame(line)
+        self.key(framed, self.dot)
+        self.frames_sent += len(seqs)
+        self.pending.append((seqs, time.monotonic() + report_timeout(self.dot)))
+        self._check(time.monotonic())
+
+    def settle(self):
+        """Wait for the reports of everything sent; returns (frames OK, frames sent)."""
+        while self.pending:
+            seqs, deadline = self.pending[0]
+            self.monitor.wait(seqs, max(0.0, deadline - time.monotonic()))
+            self._take()
+        return self.frames_ok, self.frames_sent
+
+    def _take(self):
+        seqs, _ = self.pending.popleft()
+        for seq in seqs:
+            ok = self.monitor.delivered([seq]) == 1
+            self.frames_ok += ok
+            self.window.append(ok)
+
+    def _resolve(self, now):
+        # Oldest first: a line is settled once all its frames are in or its reports are overdue
+        while self.pending:
+            seqs, deadline = self.pending[0]
+            if deadline > now and self.monitor.delivered(seqs) < len(seqs):
+                break
+            self._take()
+
+    def _check(self, now):
+        self._resolve(now)
+        # More failures than a full window may hold: no need to wait for it to fill
+        failures = self.window.count(False)
+        if failures > self.max_fer * WINDOW_FRAMES:
+            print(f"[autobaud] {failures} of the last {len(self.window)} frames lost at {self.dot * 1000:g} ms dots, "
+                  f"probing again", file=sys.stderr, flush=True)
+            self.settle()
+            self.negotiate(min(self.index + 1, len(self.ladder) - 1))
+            return
+        clean = not self.window or all(self.window)
+        if self.index > 0 and clean and now - self.changed >= self.reprobe_s:
+            self.settle()
+            if self.probe(self.index - 1):
+                self.index -= 1
+                print(f"[autobaud] link up to {self.dot * 1000:g} ms dots", file=sys.stderr, flush=True)
+            self.changed = time.monotonic()
+            self.window.clear()
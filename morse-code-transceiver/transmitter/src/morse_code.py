@@ -0,0 +1,41 @@
+"""
+Author: Noah Laforet
+Morse code table shared by the transmitters and the receiver firmware
+
+This is the single source of truth for the code: the transmitter scripts import
+MORSE_CODE directly, and tools/gen_morse_table.py turns it into the receiver's
+lookup tree (morse_table.h) at build time, so encoder and decoder cannot drift.
+
+CODE_TABLES lists every code the receiver can decode, by table id. Table 0 is
+ITU Morse; the others are generated from sample payloads by
+tools/gen_code_table.py and can be selected per frame (see morse_frame.py).
+"""
+
+from morse_code_telemetry import CODE as TELEMETRY_CODE
+
+# Morse code dictionary
+MORSE_CODE = {
+    'A': '.-',    'B': '-...',  'C': '-.-.',  'D': '-..',   'E': '.',
+    'F': '..-.',  'G': '--.',   'H': '....',  'I': '..',    'J': '.---',
+    'K': '-.-',   'L': '.-..',  'M': '--',    'N': '-.',    'O': '---',
+    'P': '.--.',  'Q': '--.-',  'R': '.-.',   'S': '...',   'T': '-',
+    'U': '..-',   'V': '...-',  'W': '.--',   'X': '-..-',  'Y': '-.--',
+    'Z': '--..',
+    '0': '-----', '1': '.----', '2': '..---', '3': '...--', '4': '....-',
+    '5': '.....', '6': '-....', '7': '--...', '8': '---..', '9': '----.',
+    '.': '.-.-.-', ',': '--..--', '?': '..--..', '=': '-...-',  '/': '-..-.',
+    '-': '-....-', ':': '---...',
+    ' ': '/',  # Space between words
+    # Prosigns used by framed mode (morse_frame.py), each sent as one character
+    '\x02': '-.-.-',  # <KA> start of frame
+    '\x03': '.-.-.',  # <AR> end of frame
+    # Prosign announcing a Manchester data burst (morse_data.py)
+    '\x16': '...-.',  # <SN> switch to data mode
+}
+
+# Message strings may switch tables in-band: SHIFT followed by a table id digit
+# applies to the characters after it. Neither character is sent.
+SHIFT = '\x0e'
+
+CODE_TABLES = [MORSE_CODE, TELEMETRY_CODE]
+TABLE_NAMES = ['itu', 'telemetry']
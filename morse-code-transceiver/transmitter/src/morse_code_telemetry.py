@@ -0,0 +1,58 @@
+"""
+Generated by tools/gen_code_table.py from telemetry.txt - do not edit.
+
+telemetry code table: the cheapest patterns go to the most frequent characters
+of the sample corpus. Prosigns keep their ITU patterns.
+Corpus: 3359 characters, 13.84 units/char with ITU Morse,
+7.98 with this table (-42%). Comments are corpus counts.
+"""
+
+CODE = {
+    '=': '.',         # 480
+    '1': '-',         # 295
+    '.': '..',        # 276
+    '0': '-.',        # 267
+    '2': '.-',        # 195
+    '3': '...',       # 184
+    '5': '--',        # 149
+    'N': '-..',       # 144
+    'R': '.-.',       # 144
+    '4': '..-',       # 136
+    '7': '....',      # 134
+    '6': '--.',       # 132
+    'T': '-.-',       # 120
+    '9': '.--',       # 108
+    '8': '-...',      # 91
+    'H': '.-..',      # 84
+    'V': '..-.',      # 84
+    'P': '...-',      # 84
+    '-': '.....',     # 84
+    'E': '---',       # 24
+    'A': '--..',      # 24
+    'C': '-.-.',      # 24
+    ':': '-..-',      # 24
+    'M': '.--.',      # 12
+    'K': '.-.-',      # 12
+    'L': '..--',      # 12
+    'O': '-....',     # 12
+    '/': '.-...',     # 12
+    '?': '..-..',     # 12
+    'I': '....-',     # 0
+    'S': '......',    # 0
+    'D': '---.',      # 0
+    'U': '--.-',      # 0
+    'B': '-.--',      # 0
+    'F': '.---',      # 0
+    'G': '--...',     # 0
+    'W': '-.-..',     # 0
+    'X': '-..-.',     # 0
+    'Z': '-...-',     # 0
+    'J': '.--..',     # 0
+    'Q': '.-..-',     # 0
+    'Y': '..--.',     # 0
+    ',': '..-.-',     # 0
+    ' ': '/',         # Word gap
+    '\x02': '-.-.-',  # Prosign
+    '\x03': '.-.-.',  # Prosign
+    '\x16': '...-.',  # Prosign
+}
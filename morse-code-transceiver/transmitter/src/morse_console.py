@@ -0,0 +1,31 @@
+"""
+Author: Noah Laforet
+The receiver's serial console, for the tools that read it
+
+morse_autobaud.py reads the @link reports from it and tools/morse_capture.py
+the capture blocks. Both open the port the same way, so a board isn't reset
+by one and not the other.
+"""
+
+CONSOLE_BAUD = 115200           # The receiver's UART console; ignored by USB-Serial-JTAG
+CONSOLE_TIMEOUT_S = 0.2         # Reads return this often, so readers can stop
+
+
+def open_console(port, baud=CONSOLE_BAUD, needed_by="this tool"):
+    """Open the console without resetting the board. Raises RuntimeError."""
+    try:
+        import serial
+    except ImportError:
+        raise RuntimeError(f"{needed_by} needs pyserial (pip install pyserial)")
+
+    console = serial.Serial()
+    console.port = port
+    console.baudrate = baud
+    console.timeout = CONSOLE_TIMEOUT_S
+    console.dtr = False             # Opening with DTR/RTS asserted resets most ESP32 boards
+    console.rts = False
+    try:
+        console.open()
+    except serial.SerialException as e:
+        raise RuntimeError(f"Can't open {port}: {e}")
+    return console
@@ -0,0 +1,87 @@
+"""
+Author: Noah Laforet
+Data mode encoder: Manchester-coded bursts
+
+Morse averages well under one bit per dot time. A data burst sends bytes
+at a fixed rate instead, as a Manchester line code on the same LED. A 0 is
+ON then OFF and a 1 is OFF then ON, so every bit has a mid-bit edge for the
+receiver to recover the clock from:
+
+    <SN>  preamble  sync  LL  payload  CCCC
+
+<SN> (...-.) is sent as ordinary Morse and switches the receiver to its bit
+slicer. The preamble of zero bits is an edge every half bit, which the
+receiver measures the rate from. After it come the sync word, the payload
+length, up to 255 payload bytes and a CRC-16/CCITT-FALSE over LL and the
+payload. The receiver side is components/morse_decoder/morse_data.c.
+
+Schedules use the same (level, units) runs as morse_schedule.py, in half-bit
+units.
+"""
+
+import functools
+
+from morse_frame import crc16
+from morse_schedule import compile_message
+
+DATA_START = '\x16'     # <SN>
+SYNC_WORD = 0xD391
+PREAMBLE_BITS = 32
+MAX_PAYLOAD = 255
+HALF_BIT_US = 500       # 1000 bit/s; the receiver needs ~10 samples per half bit
+TRAILER_HALF_BITS = 8   # OFF time after the CRC before the next Morse or burst
+
+
+def _bits(data):
+    for byte in data:
+        for shift in range(7, -1, -1):
+            yield (byte >> shift) & 1
+
+
+@functools.lru_cache(maxsize=16)
+def compile_burst(payload):
+    """Compile one burst (bytes, at most MAX_PAYLOAD) into ((level, half_bits), ...) runs."""
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError("Data burst payload longer than %d bytes" % MAX_PAYLOAD)
+
+    body = bytes([len(payload)]) + payload
+    crc = crc16(body)
+    frame = bytes(PREAMBLE_BITS // 8) + bytes([SYNC_WORD >> 8, SYNC_WORD & 0xFF]) + body + bytes([crc >> 8, crc & 0xFF])
+
+    runs = []
+
+    def add(level, units):
+        if runs and runs[-1][0] == level:
+            runs[-1] = (level, runs[-1][1] + units)
+        else:
+            runs.append((level, units))
+
+    for bit in _bits(frame):
+        add(0 if bit else 1, 1)
+        add(1 if bit else 0, 1)
+    add(0, TRAILER_HALF_BITS)
+    return tuple(runs)
+
+
+def announce_schedule():
+    """<SN> plus a word gap, in Morse dot units."""
+    return compile_message(DATA_START + ' ')
+
+
+def split_bursts(payload):
+    """Payload bytes -> compiled bursts of up to MAX_PAYLOAD bytes each."""
+    return [compile_burst(payload[start:start + MAX_PAYLOAD])
+            for start in range(0, max(len(payload), 1), MAX_PAYLOAD)]
+
+
+def data_pulses(payload, dot_us, half_bit_us=HALF_BIT_US):
+    """(level, duration_us) pulses for every burst of a payload, each announced by <SN>."""
+    pulses = []
+    for burst in split_bursts(payload):
+        pulses += [(level, units * dot_us) for level, units in announce_schedule()]
+        pulses += [(level, units * half_bit_us) for level, units in burst]
+    return pulses
+
+
+def bit_rate(half_bit_us):
+    return 1000000 / (2 * half_bit_us)
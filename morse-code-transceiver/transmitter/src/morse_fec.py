@@ -0,0 +1,82 @@
+"""
+Author: Noah Laforet
+Forward error correction for framed mode: Reed-Solomon RS(15,11) over GF(16)
+
+Hex digits are the natural symbols of a Morse frame, so the code works on
+4-bit nibbles: every block of 11 data nibbles gets 4 parity nibbles and the
+receiver can repair any 2 wrong hex digits per block, or up to 4 that it
+decoded as '?' (erasures), without a retransmission.
+
+FEC frames (type 1) carry the payload text as ASCII nibbles, RS-encoded and
+sent as hex digits. The last block is shortened instead of padded. The
+decoder is components/morse_decoder/morse_fec.c.
+
+GF(16) uses the primitive polynomial x^4 + x + 1 (alpha = 2); the generator
+polynomial is (x - a)(x - a^2)(x - a^3)(x - a^4). Codewords are sent highest
+degree first: data nibbles, then parity.
+"""
+
+RS_N = 15
+RS_K = 11
+RS_PARITY = RS_N - RS_K
+
+FRAME_TYPE_FEC = 1
+
+GF_EXP = [0] * 30
+GF_LOG = [0] * 16
+_x = 1
+for _i in range(15):
+    GF_EXP[_i] = GF_EXP[_i + 15] = _x
+    GF_LOG[_x] = _i
+    _x <<= 1
+    if _x & 0x10:
+        _x ^= 0x13
+
+
+def gf_mul(a, b):
+    if a == 0 or b == 0:
+        return 0
+    return GF_EXP[GF_LOG[a] + GF_LOG[b]]
+
+
+def _generator():
+    g = [1]
+    for j in range(1, RS_PARITY + 1):
+        # Multiply by (x - a^j); minus is plus in GF(2^m)
+        root = GF_EXP[j]
+        g = [a ^ gf_mul(b, root) for a, b in zip(g + [0], [0] + g)]
+    return g  # Highest degree first
+
+
+GENERATOR = _generator()
+
+
+def rs_encode_block(data):
+    """Append RS_PARITY parity nibbles to up to RS_K data nibbles."""
+    if len(data) > RS_K:
+        raise ValueError("RS block holds at most %d data nibbles" % RS_K)
+    remainder = list(data) + [0] * RS_PARITY
+    for i in range(len(data)):
+        coef = remainder[i]
+        if coef:
+            for j in range(1, len(GENERATOR)):
+                remainder[i + j] ^= gf_mul(GENERATOR[j], coef)
+    return list(data) + remainder[len(data):]
+
+
+def encode_payload(text):
+    """ASCII text -> RS-coded hex digit string for a type 1 frame."""
+    nibbles = []
+    for byte in text.encode('ascii'):
+        nibbles += [byte >> 4, byte & 0xF]
+
+    coded = []
+    for start in range(0, len(nibbles), RS_K):
+        coded += rs_encode_block(nibbles[start:start + RS_K])
+    return ''.join('%X' % n for n in coded)
+
+
+def encoded_length(text_length):
+    nibbles = 2 * text_length
+    blocks = (nibbles + RS_K - 1) // RS_K
+    return nibbles + blocks * RS_PARITY
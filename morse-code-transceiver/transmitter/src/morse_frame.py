@@ -0,0 +1,108 @@
+"""
+Author: Noah Laforet
+Framed mode encoder
+
+Wraps payloads in error-checked frames made of ordinary Morse characters, so
+a message can be sent once and the receiver reports whether it arrived
+intact instead of relying on repetitions:
+
+    EEEE <KA> T SS LL payload CCCC <AR>
+
+EEEE is a preamble of dots for the receiver's speed estimate to lock on, T the
+frame type (hex), SS the sequence number (hex), LL the payload length in
+characters (hex), CCCC a CRC-16/CCITT-FALSE over "T SS LL payload" and <KA>/<AR>
+the start/end prosigns. The receiver side is components/morse_decoder/morse_frame.c.
+
+With fec=True the payload goes out Reed-Solomon coded as hex digits (frame
+type 1, see morse_fec.py): 2.4x longer on air, but up to 2 misread digits per
+15 are repaired instead of failing the CRC.
+
+With table=N the payload is keyed in code table N of CODE_TABLES (morse_code.py),
+e.g. the corpus-tuned telemetry table, and the table id goes in bits 1-3 of T.
+The rest of the frame stays ITU so any receiver can find and parse the header.
+"""
+
+import re
+
+from morse_code import CODE_TABLES, MORSE_CODE, SHIFT, TABLE_NAMES
+from morse_fec import FRAME_TYPE_FEC, encode_payload
+
+STX = '\x02'    # <KA>
+ETX = '\x03'    # <AR>
+PREAMBLE = 'EEEE'
+FRAME_TYPE_TEXT = 0
+FRAME_TYPE_TABLE_SHIFT = 1  # Type bits above the FEC flag hold the code table
+MAX_PAYLOAD = 64    # Characters per frame; a corrupted frame costs at most this much
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over an ASCII string or bytes."""
+    if isinstance(data, str):
+        data = data.encode('ascii')
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def sanitize(text):
+    """Upper-case, drop characters the Morse table can't send and collapse runs of spaces.
+
+    The receiver reports one space per word gap however long it is, so LL and
+    the CRC must count a run of spaces as one.
+    """
+    text = ''.join(c for c in text.upper() if c in MORSE_CODE and c >= ' ')
+    return re.sub(' {2,}', ' ', text)
+
+
+def encode_frame(payload, seq, frame_type=FRAME_TYPE_TEXT, table=0):
+    """One frame as a Morse-sendable string. The payload must be sanitized."""
+    if len(payload) > 255:
+        raise ValueError("Frame payload longer than 255 characters")
+    if not 0 <= table < len(CODE_TABLES):
+        raise ValueError("No code table %d" % table)
+    header = f"{frame_type | table << FRAME_TYPE_TABLE_SHIFT:X}{seq & 0xFF:02X}{len(payload):02X}"
+    crc = crc16(header + payload)
+    if table:
+        payload = f"{SHIFT}{table}{payload}{SHIFT}0"
+    return f"{PREAMBLE}{STX}{header}{payload}{crc:04X}{ETX}"
+
+
+def split_frames(text, first_seq=0, max_payload=MAX_PAYLOAD, fec=False, table=0):
+    """Sanitize a message and split it into consecutive frames."""
+    text = sanitize(text)
+    frames = []
+    for i, start in enumerate(range(0, max(len(text), 1), max_payload)):
+        chunk = text[start:start + max_payload]
+        if fec:
+            frames.append(encode_frame(encode_payload(chunk), first_seq + i, FRAME_TYPE_FEC, table))
+        else:
+            frames.append(encode_frame(chunk, first_seq + i, FRAME_TYPE_TEXT, table))
+    return frames
+
+
+def frame_text(frames):
+    """Frames joined by word gaps, ready for compile_message()."""
+    return ' '.join(frames)
+
+
+class Framer:
+    """Frames successive messages with a running sequence number."""
+
+    def __init__(self, first_seq=0, fec=False, table=0):
+        self.seq = first_seq
+        self.fec = fec
+        self.table = table
+
+    def frame(self, text):
+        frames = split_frames(text, self.seq, fec=self.fec, table=self.table)
+        self.seq = (self.seq + len(frames)) & 0xFF
+        return frame_text(frames)
+
+
+def printable(text):
+    text = text.replace(STX, '<KA>').replace(ETX, '<AR>')
+    return re.sub(SHIFT + '([0-9])', lambda m: '[%s]' % TABLE_NAMES[int(m.group(1))], text)
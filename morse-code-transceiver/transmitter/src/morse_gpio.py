@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+"""
+Author: Noah Laforet
+LED output backends for the software-timed players
+
+play_schedule() (morse_schedule.py) times every edge itself and only needs
+write(level) to set the LEDs, so the GPIO library behind it is swappable:
+
+    gpio     RPi.GPIO; not available on the Pi 5
+    lgpio    lgpio on the GPIO character device; every Pi including the 5
+    mmap     stores to the GPSET0/GPCLR0 registers through /dev/gpiomem;
+             BCM2835 to BCM2711 (Pi 1 to 4), not the Pi 5's RP1
+    pigpio   one daemon call per edge; compare with the DMA waveforms of
+             morse_waveform.py, which the transmitters' --backend pigpio uses
+    mock     no hardware: records every edge with its perf_counter time, so
+             the encoder and player can be run and timed on any machine
+
+Levels are lane masks as everywhere else: bit i drives pins[i]. Every backend
+turns a mask into its own form once, at open, so write() is a table lookup
+and one library call.
+
+Run this file to measure the backends on a board and pick the fastest:
+
+    python3 morse_gpio.py [--pins 17] [--toggles 10000] [--dot-ms 1] [backend ...]
+
+For each backend that opens it prints the time one write() takes and how
+late the edges of a played message are against their deadlines.
+"""
+
+import argparse
+import mmap
+import os
+import time
+
+from morse_schedule import compile_message, play_schedule
+
+BCM_GPIO_BANK = 32      # Pins in GPSET0/GPCLR0: every pin on the header
+
+
+class Backend:
+    """write(level) sets the LEDs to a lane mask; close() turns them off and releases them."""
+
+    def __init__(self, pins):
+        self.pins = list(pins)
+        self.levels = 1 << len(self.pins)
+
+    def gpio_mask(self, level):
+        return sum(1 << pin for lane, pin in enumerate(self.pins) if level >> lane & 1)
+
+    def write(self, level):
+        raise NotImplementedError
+
+    def close(self):
+        self.write(0)
+
+
+class RPiGpioBackend(Backend):
+    def __init__(self, pins):
+        super().__init__(pins)
+        try:
+            import RPi.GPIO as GPIO
+        except ImportError:
+            raise RuntimeError("gpio backend needs RPi.GPIO (sudo apt-get install python3-rpi.gpio)")
+
+        self.GPIO = GPIO
+        GPIO.setmode(GPIO.BCM)
+        GPIO.setwarnings(False)
+        GPIO.setup(self.pins, GPIO.OUT)
+        self._outputs = [[GPIO.HIGH if level >> lane & 1 else GPIO.LOW for lane in range(len(self.pins))]
+                         for level in range(self.levels)]
+        self.write(0)
+
+    def write(self, level):
+        self.GPIO.output(self.pins, self._outputs[level])
+
+    def close(self):
+        self.write(0)
+        self.GPIO.cleanup()
+
+
+class LgpioBackend(Backend):
+    def __init__(self, pins):
+        super().__init__(pins)
+        try:
+            import lgpio
+        except ImportError:
+            raise RuntimeError("lgpio backend needs lgpio (sudo apt-get install python3-lgpio)")
+
+        self.lgpio = lgpio
+        self.handle = self._open_chip()
+        # A group write sets bit i of the level on pins[i]: the lane mask as it is
+        lgpio.group_claim_output(self.handle, self.pins)
+        self.write(0)
+
+    def _open_chip(self):
+        # The header's chip is gpiochip0 up to the Pi 4 and gpiochip4 (later also 0) on a Pi 5
+        for chip in range(5):
+            try:
+                handle = self.lgpio.gpiochip_open(chip)
+            except self.lgpio.error:
+                continue
+            if self.lgpio.gpio_get_chip_info(handle)[3].startswith("pinctrl-"):
+                return handle
+            self.lgpio.gpiochip_close(handle)
+        raise RuntimeError("No pinctrl GPIO chip found in /dev/gpiochip*")
+
+    def write(self, level):
+        self.lgpio.group_write(self.handle, self.pins[0], level)
+
+    def close(self):
+        self.write(0)
+        self.lgpio.group_free(self.handle, self.pins[0])
+        self.lgpio.gpiochip_close(self.handle)
+
+
+class MmapBackend(Backend):
+    # Word offsets into the BCM283x/BCM2711 GPIO block
+    GPFSEL0 = 0
+    GPSET0 = 7
+    GPCLR0 = 10
+
+    def __init__(self, pins):
+        super().__init__(pins)
+        try:
+            with open("/proc/device-tree/compatible", "rb") as f:
+                if b"brcm,bcm2712" in f.read():
+                    raise RuntimeError("mmap backend drives BCM283x/BCM2711 GPIO; on a Pi 5 use --backend lgpio")
+        except OSError:
+            pass
+        if any(pin >= BCM_GPIO_BANK for pin in self.pins):
+            raise RuntimeError(f"mmap backend drives GPIO 0-{BCM_GPIO_BANK - 1} only")
+        try:
+            fd = os.open("/dev/gpiomem", os.O_RDWR | os.O_SYNC)
+        except OSError as e:
+            raise RuntimeError(f"Can't open /dev/gpiomem: {e}")
+        try:
+            self._map = mmap.mmap(fd, mmap.PAGESIZE, mmap.MAP_SHARED, mmap.PROT_READ | mmap.PROT_WRITE)
+        finally:
+            os.close(fd)
+        # One aligned 32-bit store per register write, as the block requires
+        self._regs = memoryview(self._map).cast("I")
+
+        for pin in self.pins:
+            fsel = self.GPFSEL0 + pin // 10
+            shift = pin % 10 * 3
+            self._regs[fsel] = self._regs[fsel] & ~(7 << shift) | 1 << shift    # 001: output
+        everything = self.gpio_mask(-1)
+        self._writes = [(self.gpio_mask(level), everything & ~self.gpio_mask(level)) for level in range(self.levels)]
+        self.write(0)
+
+    def write(self, level):
+        on, off = self._writes[level]
+        regs = self._regs
+        regs[self.GPCLR0] = off
+        if on:
+            regs[self.GPSET0] = on
+
+    def close(self):
+        self.write(0)
+        self._regs.release()
+        self._map.close()
+
+
+class PigpioBackend(Backend):
+    def __init__(self, pins):
+        super().__init__(pins)
+        try:
+            import pigpio
+        except ImportError:
+            raise RuntimeError("pigpio backend needs pigpio (sudo apt-get install pigpio python3-pigpio)")
+
+        self.pi = pigpio.pi()
+        if not self.pi.connected:
+            raise RuntimeError("Cannot connect to pigpio daemon (start it with: sudo pigpiod)")
+        for pin in self.pins:
+            self.pi.set_mode(pin, pigpio.OUTPUT)
+        everything = self.gpio_mask(-1)
+        self._writes = [(self.gpio_mask(level), everything & ~self.gpio_mask(level)) for level in range(self.levels)]
+        self.write(0)
+
+    def write(self, level):
+        on, off = self._writes[level]
+        self.pi.clear_bank_1(off)
+        if on:
+            self.pi.set_bank_1(on)
+
+    def close(self):
+        self.write(0)
+        self.pi.stop()
+
+
+class MockBackend(Backend):
+    """Records (perf_counter_ns, level) for every change of level; writes them as CSV on close if given a path."""
+
+    def __init__(self, pins, path=None):
+        super().__init__(pins)
+        self.path = path
+        self.edges = []
+        self.level = 0
+
+    def write(self, level):
+        if level != self.level:
+            self.edges.append((time.perf_counter_ns(), level))
+            self.level = level
+
+    def close(self):
+        self.write(0)
+        if self.path:
+            start = self.edges[0][0] if self.edges else 0
+            with open(self.path, "w") as f:
+                f.write("t_us,level\n")
+                for t_ns, level in self.edges:
+                    f.write(f"{(t_ns - start) / 1000:.3f},{level}\n")
+
+
+BACKENDS = {
+    "gpio": RPiGpioBackend,
+    "lgpio": LgpioBackend,
+    "mmap": MmapBackend,
+    "pigpio": PigpioBackend,
+    "mock": MockBackend,
+}
+
+
+def open_backend(name, pins, edges=None):
+    """Open an output backend by name; edges is the mock's CSV path. Raises RuntimeError if it can't open."""
+    if name == "mock":
+        return MockBackend(pins, edges)
+    return BACKENDS[name](pins)
+
+
+BENCH_MESSAGE = "PARIS "
+BENCH_REPETITIONS = 20      # About 600 edges
+
+
+def percentile(sorted_values, fraction):
+    return sorted_values[min(len(sorted_values) - 1, int(fraction * len(sorted_values)))]
+
+
+def toggle_latency(backend, toggles):
+    """Sorted per-write() times in microseconds, alternating all LEDs on and off."""
+    on = backend.levels - 1
+    times = []
+    clock = time.perf_counter_ns
+    for i in range(toggles):
+        start = clock()
+        backend.write(on if i & 1 == 0 else 0)
+        times.append(clock() - start)
+    backend.write(0)
+    return sorted(t / 1000 for t in times)
+
+
+def edge_lateness(backend, dot_s):
+    """Sorted lateness in microseconds of every write() return against its deadline in play_schedule()."""
+    schedule = compile_message(BENCH_MESSAGE) * BENCH_REPETITIONS
+    stamps = []
+    clock = time.perf_counter
+
+    def write(level):
+        backend.write(level)
+        stamps.append(clock())
+
+    # play_schedule() takes its start time on entry: edge k is due after runs 0..k-1
+    deadlines = [clock()]
+    play_schedule(schedule, dot_s, write)
+    for _, units in schedule:
+        deadlines.append(deadlines[-1] + units * dot_s)
+    return sorted((stamp - deadline) * 1000000 for stamp, deadline in zip(stamps, deadlines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure LED output backends: write() latency and edge timing")
+    parser.add_argument("backends", nargs="*", metavar="backend",
+                        help=f"{', '.join(BACKENDS)} (default all; those that can't open are skipped)")
+    parser.add_argument("--pins", default="17", help="comma-separated LED GPIO pins (default %(default)s)")
+    parser.add_argument("--toggles", type=int, default=10000, help="writes timed per backend (default %(default)d)")
+    parser.add_argument("--dot-ms", type=float, default=1.0,
+                        help="dot length of the timed message (default %(default)g)")
+    args = parser.parse_args()
+    pins = [int(pin) for pin in args.pins.split(",")]
+    unknown = [name for name in args.backends if name not in BACKENDS]
+    if unknown:
+        parser.error(f"unknown backend {unknown[0]}")
+
+    print(f"{'backend':<8}{'write mean':>12}{'p99':>9}{'max':>9}   {'edge late mean':>14}{'p99':>9}{'max':>9}   (us)")
+    results = []
+    for name in args.backends or BACKENDS:
+        try:
+            backend = open_backend(name, pins)
+        except RuntimeError as e:
+            print(f"{name:<8}unavailable: {e}")
+            continue
+        try:
+            writes = toggle_latency(backend, args.toggles)
+            late = edge_lateness(backend, args.dot_ms / 1000)
+        finally:
+            backend.close()
+        mean = sum(writes) / len(writes)
+        print(f"{name:<8}{mean:>12.2f}{percentile(writes, 0.99):>9.2f}{writes[-1]:>9.1f}   "
+              f"{sum(late) / len(late):>14.1f}{percentile(late, 0.99):>9.1f}{late[-1]:>9.1f}")
+        if name != "mock":
+            results.append((mean, name))
+
+    if results:
+        print(f"Fastest hardware backend here: {min(results)[1]}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,84 @@
+"""
+Author: Noah Laforet
+Multi-LED striping
+
+Sends one framed message over several LEDs at once, one per receiver
+photodiode (see the multi-channel receiver in the README). The message is
+split into frames exactly as in morse_frame.py, and frame k goes out on lane
+k mod N with sequence number first_seq + k. That sequence number is the lane
+tag: the receiver puts the frames back in order whichever photodiode saw
+them (components/morse_decoder/morse_lanes.c), so aggregate throughput
+grows with the number of lanes.
+
+The lanes are driven in lockstep from one schedule: the per-lane schedules
+from morse_schedule.py are merged into (mask, units) runs, where bit i of
+mask is the level of lane i. Lanes that finish early stay dark.
+"""
+
+from morse_frame import MAX_PAYLOAD, frame_text, split_frames, sanitize
+from morse_schedule import compile_message, schedule_units
+
+
+def stripe_frames(text, lanes, first_seq=0, fec=False, table=0):
+    """Sanitize a message and split it into frames for `lanes` LEDs.
+
+    The frame size is chosen so every lane gets the same number of frames,
+    so the lanes finish at about the same time. Returns one list of frames
+    per lane.
+    """
+    text = sanitize(text)
+    frames_per_lane = max(1, -(-len(text) // (lanes * MAX_PAYLOAD)))
+    max_payload = max(1, -(-len(text) // (lanes * frames_per_lane)))
+    frames = split_frames(text, first_seq, max_payload, fec, table)
+    return [frames[lane::lanes] for lane in range(lanes)]
+
+
+def merge_schedules(schedules):
+    """Merge per-lane ((level, units), ...) schedules into ((mask, units), ...) runs."""
+    edges = {}
+    for lane, schedule in enumerate(schedules):
+        time = 0
+        for level, units in schedule:
+            edges.setdefault(time, {})[lane] = level
+            time += units
+        edges.setdefault(time, {})[lane] = 0
+
+    runs = []
+    mask = 0
+    times = sorted(edges)
+    for start, end in zip(times, times[1:]):
+        for lane, level in edges[start].items():
+            mask = (mask | 1 << lane) if level else (mask & ~(1 << lane))
+        if runs and runs[-1][0] == mask:
+            runs[-1] = (mask, runs[-1][1] + end - start)
+        else:
+            runs.append((mask, end - start))
+    return tuple(runs)
+
+
+def lane_schedule(messages):
+    """Compile one message per lane and merge them into a single schedule."""
+    return merge_schedules([compile_message(message) for message in messages])
+
+
+def speedup(messages):
+    """On-air time of the lanes sent one after another over the striped time."""
+    striped = schedule_units(lane_schedule(messages))
+    serial = sum(schedule_units(compile_message(message)) for message in messages)
+    return serial / striped if striped else 1.0
+
+
+class LaneFramer:
+    """Stripes successive messages with a running sequence number."""
+
+    def __init__(self, lanes, first_seq=0, fec=False, table=0):
+        self.lanes = lanes
+        self.seq = first_seq
+        self.fec = fec
+        self.table = table
+
+    def frame(self, text):
+        """One Morse-sendable string per lane."""
+        lanes = stripe_frames(text, self.lanes, self.seq, self.fec, self.table)
+        self.seq = (self.seq + sum(len(frames) for frames in lanes)) & 0xFF
+        return [frame_text(frames) for frames in lanes]
@@ -0,0 +1,141 @@
+"""
+Author: Noah Laforet
+Morse message compiler and deadline-based player
+
+A message is compiled once into a run-length schedule: a tuple of
+(level, units) runs in whole dot units, with adjacent runs at the same level
+merged. Compiled schedules are cached, so repetitions (and repeated messages)
+never look anything up again.
+
+Playback schedules every edge against an absolute deadline measured from the
+start of the transmission, so sleep overshoot on one edge is absorbed by the
+next instead of accumulating, and nothing but the GPIO write runs between
+edges.
+
+A receiver built with CONFIG_MORSE_LIGHT_SLEEP wakes on light and skips the
+first pulse after a long idle, so transmissions after one start with a wake
+preamble (WakePreamble).
+"""
+
+import functools
+import time
+
+from morse_code import CODE_TABLES, MORSE_CODE, SHIFT
+
+# Standard timing ratios in dot units
+DOT_UNITS = 1
+DASH_UNITS = 3
+SYMBOL_SPACE_UNITS = 1
+LETTER_SPACE_UNITS = 3
+WORD_SPACE_UNITS = 7
+
+# Sleep until this close to a deadline, then spin (time.sleep overshoots)
+SPIN_S = 0.0005
+
+# Receiver idle time before it sleeps and expects a wake preamble (CONFIG_MORSE_SLEEP_IDLE_MS)
+WAKE_IDLE_S = 2.0
+
+
+def _coded(message):
+    """Yield (char, code table) for every sendable character, following SHIFTs."""
+    code = MORSE_CODE
+    chars = iter(message.upper())
+    for char in chars:
+        if char == SHIFT:
+            code = CODE_TABLES[int(next(chars))]
+        elif char in code:
+            yield char, code
+
+
+@functools.lru_cache(maxsize=64)
+def compile_message(message):
+    """Compile a message into ((level, units), ...) runs.
+
+    Symbols are separated by 1 unit, letters by 3 and words by 7, and the
+    message ends with a letter gap so repetitions run back to back.
+    Characters without a Morse code are skipped. SHIFT + table id switches
+    the code table for the characters that follow.
+    """
+    runs = []
+
+    def add(level, units):
+        if runs and runs[-1][0] == level:
+            runs[-1] = (level, runs[-1][1] + units)
+        else:
+            runs.append((level, units))
+
+    for char, code in _coded(message):
+        if char == ' ':
+            # A letter gap already follows the previous character
+            add(0, WORD_SPACE_UNITS - LETTER_SPACE_UNITS)
+            continue
+
+        for symbol in code[char]:
+            add(1, DOT_UNITS if symbol == '.' else DASH_UNITS)
+            add(0, SYMBOL_SPACE_UNITS)
+        add(0, LETTER_SPACE_UNITS - SYMBOL_SPACE_UNITS)
+
+    return tuple(runs)
+
+
+def message_pattern(message):
+    """Dot/dash text for the console, e.g. '... --- ... / .'"""
+    return ' '.join(code[char] for char, code in _coded(message))
+
+
+def schedule_units(schedule):
+    return sum(units for _, units in schedule)
+
+
+def wait_until(deadline):
+    remaining = deadline - time.perf_counter()
+    if remaining > SPIN_S:
+        time.sleep(remaining - SPIN_S)
+    while time.perf_counter() < deadline:
+        pass
+
+
+class WakePreamble:
+    """When to send the wake preamble, and what it is.
+
+    The receiver skips the first pulse after CONFIG_MORSE_SLEEP_IDLE_MS of
+    darkness whether it got to sleep or not, so the preamble goes out exactly
+    when the light has been off for idle_s: at start-up, and after a pause in
+    stream mode. It is preamble_s of light, which only has to outlast the
+    receiver's wake-up, then a word gap. Every channel skips its own first
+    pulse, so with several LEDs the preamble lights all of them (`lanes` mask).
+    """
+
+    def __init__(self, preamble_s, idle_s, lanes=1):
+        self.preamble_s = preamble_s
+        self.idle_s = idle_s
+        self.lanes = lanes
+        self.dark_since = None      # perf_counter() when the light last went off
+
+    def due(self):
+        if self.preamble_s <= 0:
+            return False
+        return self.dark_since is None or time.perf_counter() - self.dark_since >= self.idle_s
+
+    def schedule(self, dot_s):
+        """(level, units) runs for play_schedule(); the ON run is not a whole number of units."""
+        return ((self.lanes, self.preamble_s / dot_s), (0, WORD_SPACE_UNITS))
+
+    def pulses(self, dot_us):
+        """(level, duration_us) pulses for the waveform backend."""
+        return [(self.lanes, int(round(self.preamble_s * 1000000))), (0, WORD_SPACE_UNITS * dot_us)]
+
+    def finished(self, trailing_dark_s):
+        """A transmission just ended with trailing_dark_s of darkness."""
+        self.dark_since = time.perf_counter() - trailing_dark_s
+
+
+def play_schedule(schedule, dot_s, write, repetitions=1):
+    """Play a compiled schedule `repetitions` times through write(level)."""
+    deadline = time.perf_counter()
+    for _ in range(repetitions):
+        for level, units in schedule:
+            write(level)
+            deadline += units * dot_s
+            wait_until(deadline)
+    write(0)
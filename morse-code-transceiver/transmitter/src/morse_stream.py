@@ -0,0 +1,145 @@
+"""
+Author: Noah Laforet
+Streaming transmit mode
+
+Reads lines from stdin or a FIFO on a reader thread into a bounded queue and
+transmits them back to back from the main thread, so GPIO is set up once and
+the channel keeps sending as long as input arrives. Consecutive lines are
+separated by a word gap.
+
+Backpressure: when the queue is full the reader blocks and stops reading, so
+a producer writing into the pipe blocks too instead of piling up unbounded
+input. A FIFO is reopened when its writer closes it; stdin ends the stream at
+EOF once the queue has drained.
+
+Pipelining: given an encode(line) function, run_stream() frames and compiles
+each line on an encoder thread while the line before it plays, and hands
+send_line() the result instead of the text. At most PIPELINE_DEPTH encoded
+lines wait for the player, so the next line is ready the moment the current
+one ends and the channel carries no dead air between lines.
+"""
+
+import os
+import queue
+import stat
+import sys
+import threading
+import time
+
+QUEUE_SIZE = 16             # Lines buffered between reader and transmitter
+PIPELINE_DEPTH = 1          # Encoded lines ready while one plays
+STATS_INTERVAL_S = 10       # Seconds between throughput reports
+
+_EOF = object()
+
+
+class StreamStats:
+    def __init__(self):
+        self.start = time.monotonic()
+        self.lines = 0
+        self.chars = 0
+        self.busy_s = 0.0           # Time spent transmitting
+        self.blocked_s = 0.0        # Time the reader waited on a full queue
+        self.max_depth = 0
+        self.encode_s = 0.0         # Encoder thread time, with pipelining
+        self.encode_max_s = 0.0
+
+    def report(self, depth):
+        elapsed = time.monotonic() - self.start
+        rate = self.chars / elapsed if elapsed > 0 else 0.0
+        duty = 100.0 * self.busy_s / elapsed if elapsed > 0 else 0.0
+        print(f"[stream] {self.lines} lines, {self.chars} chars, {rate:.1f} chars/s, "
+              f"channel busy {duty:.0f}%, queue {depth} (max {self.max_depth}), "
+              f"reader blocked {self.blocked_s:.1f}s", file=sys.stderr, flush=True)
+        if self.encode_s:
+            print(f"[stream] encoding {1000 * self.encode_s / max(self.lines, 1):.2f} ms/line "
+                  f"(max {1000 * self.encode_max_s:.2f} ms), overlapped with playback", file=sys.stderr, flush=True)
+
+
+def _open_lines(source):
+    """Yield lines from stdin ('-') or a file/FIFO, reopening a FIFO at EOF."""
+    if source == '-':
+        yield from sys.stdin
+        return
+
+    is_fifo = stat.S_ISFIFO(os.stat(source).st_mode)
+    while True:
+        with open(source) as f:  # Blocks until a writer opens the FIFO
+            yield from f
+        if not is_fifo:
+            return
+
+
+def _reader(source, lines, stats):
+    try:
+        for line in _open_lines(source):
+            line = line.strip()
+            if not line:
+                continue
+            started = time.monotonic()
+            lines.put(line)  # Blocks while the queue is full
+            stats.blocked_s += time.monotonic() - started
+            stats.max_depth = max(stats.max_depth, lines.qsize())
+    finally:
+        lines.put(_EOF)
+
+
+def _encoder(lines, ready, encode, stats):
+    try:
+        while True:
+            line = lines.get()
+            if line is _EOF:
+                break
+            started = time.monotonic()
+            encoded = encode(line)
+            took = time.monotonic() - started
+            stats.encode_s += took
+            stats.encode_max_s = max(stats.encode_max_s, took)
+            ready.put((line, encoded))  # Blocks while PIPELINE_DEPTH lines wait
+    except Exception as e:
+        ready.put(e)    # Raised again by the player
+    finally:
+        ready.put(_EOF)
+
+
+def run_stream(source, send_line, queue_size=QUEUE_SIZE, stats_interval=STATS_INTERVAL_S, encode=None):
+    """Transmit lines from `source` with send_line(text) until the input ends.
+
+    With encode, send_line() gets encode(text), computed on the encoder
+    thread ahead of playback.
+    """
+    lines = queue.Queue(maxsize=queue_size)
+    stats = StreamStats()
+    threading.Thread(target=_reader, args=(source, lines, stats), daemon=True).start()
+    player = lines
+    if encode:
+        player = queue.Queue(maxsize=PIPELINE_DEPTH)
+        threading.Thread(target=_encoder, args=(lines, player, encode, stats), daemon=True).start()
+
+    next_report = time.monotonic() + stats_interval
+    try:
+        while True:
+            try:
+                line = player.get(timeout=max(0.0, next_report - time.monotonic()))
+            except queue.Empty:
+                line = None
+
+            if line is _EOF:
+                break
+            if isinstance(line, Exception):
+                raise line
+            if line is not None:
+                encoded = line
+                if encode:
+                    line, encoded = line
+                started = time.monotonic()
+                send_line(encoded)
+                stats.busy_s += time.monotonic() - started
+                stats.lines += 1
+                stats.chars += len(line)
+
+            if time.monotonic() >= next_report:
+                stats.report(lines.qsize())
+                next_report += stats_interval
+    finally:
+        stats.report(lines.qsize())
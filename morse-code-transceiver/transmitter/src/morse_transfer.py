@@ -0,0 +1,182 @@
+"""
+Author: Noah Laforet
+File transfer with selective retransmission
+
+Sends a file as numbered chunks in ordinary CRC frames (morse_frame.py) and
+uses the receiver's @link reports over USB serial (morse_autobaud.py) as
+acknowledgements, so only lost frames go out again instead of the whole
+message N times. Frame payloads, all plain Morse characters:
+
+    FILE CCCC BBBBBBBB   start: chunk count and file size (hex, no spaces)
+    FD NNNN base32       chunk N of the file: CHUNK_BYTES bytes, base32 without padding
+    FEND                 end of the transfer
+
+Up to `window` chunk frames are in flight at once. Reports come back in the
+order the frames were keyed, so a frame whose report is missing when a later
+frame's has arrived was lost (a negative acknowledgement) and its chunk is
+queued to go out again at once. A frame with no report at all after
+report_timeout() is lost too. The start and end frames are resent until they
+are acknowledged. The receiver (components/morse_decoder/morse_transfer.c)
+counts distinct chunks and logs its own goodput; with link reports on it
+prints the start frame and every new chunk as "@chunk <payload>", from
+which --rebuild writes the last file in a console capture back out:
+
+    python3 morse_transfer.py --rebuild console.log received.bin
+"""
+
+import base64
+import collections
+import re
+import sys
+import time
+
+from morse_autobaud import report_timeout
+
+START_TAG = "FILE"
+CHUNK_TAG = "FD"
+END_TAG = "FEND"
+CHUNK_BYTES = 35            # 56 base32 characters, 62 with the tag: just under MAX_PAYLOAD
+MAX_CHUNKS = 4096           # MORSE_TRANSFER_MAX_CHUNKS on the receiver
+WINDOW = 8                  # Chunk frames in flight
+MAX_ATTEMPTS = 10           # Sends of one frame before the transfer gives up
+
+START_LINE = re.compile(r"@chunk " + START_TAG + r"([0-9A-F]{4})([0-9A-F]{8})")
+CHUNK_LINE = re.compile(r"@chunk " + CHUNK_TAG + r"([0-9A-F]{4})([A-Z2-7]+)")
+
+
+def encode_chunk(index, data):
+    return f"{CHUNK_TAG}{index:04X}{base64.b32encode(data).decode('ascii').rstrip('=')}"
+
+
+def decode_chunk(text):
+    return base64.b32decode(text + "=" * (-len(text) % 8))
+
+
+def chunk_payloads(data):
+    chunks = [encode_chunk(i, data[start:start + CHUNK_BYTES])
+              for i, start in enumerate(range(0, len(data), CHUNK_BYTES))]
+    if not chunks:
+        raise ValueError("Nothing to send: the file is empty")
+    if len(chunks) > MAX_CHUNKS:
+        raise ValueError(f"File too large: {len(chunks)} chunks, the receiver tracks {MAX_CHUNKS}")
+    return chunks
+
+
+class FileSender:
+    """Sends one file over a negotiated link (a morse_autobaud.LinkRate)."""
+
+    def __init__(self, link, window=WINDOW):
+        self.link = link
+        self.window = window
+        self.frames = 0
+        self.resent = 0
+
+    def _send(self, payload):
+        framed, seqs = self.link.frame(payload)
+        self.link.key(framed, self.link.dot)
+        self.frames += len(seqs)
+        return seqs[0]
+
+    def _send_acknowledged(self, payload):
+        for _ in range(MAX_ATTEMPTS):
+            seq = self._send(payload)
+            if self.link.monitor.wait([seq], report_timeout(self.link.dot)):
+                return
+            self.resent += 1
+        raise RuntimeError(f"{payload[:4]} frame not acknowledged after {MAX_ATTEMPTS} tries; check the link")
+
+    def send(self, data):
+        """Returns (seconds from the start frame to the last chunk acknowledged, frames keyed)."""
+        chunks = chunk_payloads(data)
+        monitor = self.link.monitor
+        started = time.monotonic()
+        self._send_acknowledged(f"{START_TAG}{len(chunks):04X}{len(data):08X}")
+
+        queue = collections.deque(range(len(chunks)))   # Chunks to key, resends first
+        attempts = [0] * len(chunks)
+        done = [False] * len(chunks)
+        in_flight = collections.OrderedDict()           # seq -> (chunk, deadline), in keying order
+        remaining = len(chunks)
+        last_ack = started
+
+        while remaining:
+            # Everything keyed before an acknowledged frame has been reported on
+            lost = []
+            gap = []
+            now = time.monotonic()
+            for seq, (chunk, deadline) in list(in_flight.items()):
+                if monitor.delivered([seq]):
+                    del in_flight[seq]
+                    lost += gap
+                    gap = []
+                    if not done[chunk]:
+                        done[chunk] = True
+                        remaining -= 1
+                        last_ack = now
+                elif deadline <= now:
+                    lost.append(seq)
+                else:
+                    gap.append(seq)
+            for seq in lost:
+                chunk, _ = in_flight.pop(seq)
+                if not done[chunk]:
+                    queue.appendleft(chunk)
+                    self.resent += 1
+
+            if queue and len(in_flight) < self.window:
+                chunk = queue.popleft()
+                if done[chunk]:
+                    continue
+                attempts[chunk] += 1
+                if attempts[chunk] > MAX_ATTEMPTS:
+                    raise RuntimeError(f"Chunk {chunk} lost {MAX_ATTEMPTS} times; check the link")
+                seq = self._send(chunks[chunk])
+                in_flight[seq] = (chunk, time.monotonic() + report_timeout(self.link.dot))
+            elif remaining:
+                time.sleep(0.02)
+
+        self._send_acknowledged(END_TAG)
+        return last_ack - started, self.frames
+
+
+def rebuild(lines):
+    """Bytes of the last file in a console capture; raises ValueError if any of it is missing."""
+    count = size = None
+    chunks = {}
+    for line in lines:
+        match = START_LINE.search(line)
+        if match:
+            count, size = int(match.group(1), 16), int(match.group(2), 16)
+            chunks = {}
+            continue
+        match = CHUNK_LINE.search(line)
+        if match and count is not None:
+            chunks[int(match.group(1), 16)] = decode_chunk(match.group(2))
+    if count is None:
+        raise ValueError("No transfer start (@chunk FILE...) found")
+    missing = [i for i in range(count) if i not in chunks]
+    if missing:
+        raise ValueError(f"{len(missing)} of {count} chunk(s) missing, first {missing[0]}")
+    data = b"".join(chunks[i] for i in range(count))
+    if len(data) != size:
+        raise ValueError(f"Rebuilt {len(data)} bytes, the transfer announced {size}")
+    return data
+
+
+def main():
+    if len(sys.argv) != 4 or sys.argv[1] != "--rebuild":
+        print("Usage: python3 morse_transfer.py --rebuild <console.log> <output file>")
+        sys.exit(1)
+    with open(sys.argv[2], errors="replace") as f:
+        try:
+            data = rebuild(f)
+        except ValueError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+    with open(sys.argv[3], "wb") as f:
+        f.write(data)
+    print(f"{len(data)} bytes written to {sys.argv[3]}")
+
+
+if __name__ == "__main__":
+    main()
@@ -5,97 +5,81 @@ Morse Code Transmitter - Raspberry Pi LED Controller
 Transmits text messages as Morse code via LED on GPIO pin
 """
 
-import RPi.GPIO as GPIO
-import time
+import argparse
 import sys
 
+from morse_gpio import BACKENDS, open_backend
+from morse_schedule import compile_message, message_pattern, play_schedule
+from morse_stream import QUEUE_SIZE, run_stream
+
 # LED Configuration
 LED_PIN = 17  # GPIO pin number
+led = None    # Output backend (morse_gpio.py)
 
 # Morse code timing (in seconds)
 DOT = 0.2              # Duration of a dot
-DASH = DOT * 3         # Duration of a dash (3 dots)
-SYMBOL_SPACE = DOT     # Space between dots and dashes within a character
-LETTER_SPACE = DOT * 3 # Space between letters
-WORD_SPACE = DOT * 7   # Space between words
-
-# Morse code dictionary
-MORSE_CODE = {
-    'A': '.-',    'B': '-...',  'C': '-.-.',  'D': '-..',   'E': '.',
-    'F': '..-.',  'G': '--.',   'H': '....',  'I': '..',    'J': '.---',
-    'K': '-.-',   'L': '.-..',  'M': '--',    'N': '-.',    'O': '---',
-    'P': '.--.',  'Q': '--.-',  'R': '.-.',   'S': '...',   'T': '-',
-    'U': '..-',   'V': '...-',  'W': '.--',   'X': '-..-',  'Y': '-.--',
-    'Z': '--..',
-    '0': '-----', '1': '.----', '2': '..---', '3': '...--', '4': '....-',
-    '5': '.....', '6': '-....', '7': '--...', '8': '---..', '9': '----.',
-    ' ': '/'  # Space between words
-}
-
-def setup_gpio():
-    GPIO.setmode(GPIO.BCM)
-    GPIO.setwarnings(False)
-    GPIO.setup(LED_PIN, GPIO.OUT)
-    GPIO.output(LED_PIN, GPIO.LOW)
-
-def cleanup_gpio():
-    GPIO.output(LED_PIN, GPIO.LOW)
-    GPIO.cleanup()
-
-def send_dot():
-    GPIO.output(LED_PIN, GPIO.HIGH)
-    time.sleep(DOT)
-    GPIO.output(LED_PIN, GPIO.LOW)
-    time.sleep(SYMBOL_SPACE)
-
-def send_dash():
-    GPIO.output(LED_PIN, GPIO.HIGH)
-    time.sleep(DASH)
-    GPIO.output(LED_PIN, GPIO.LOW)
-    time.sleep(SYMBOL_SPACE)
-
-def send_character(char):
-    char = char.upper()
-
-    if char == ' ':
-        # For space, wait word space duration
-        time.sleep(WORD_SPACE - LETTER_SPACE)  # Subtract letter space since it's added after each char
-        return
+# Dashes and spaces are whole multiples of DOT (see morse_schedule.py)
 
-    if char not in MORSE_CODE:
-        # Skip characters not in Morse code dictionary
-        return
+def setup_gpio(backend="gpio", edges=None):
+    global led
+    led = open_backend(backend, [LED_PIN], edges)
 
-    morse = MORSE_CODE[char]
-    print(morse, end=' ', flush=True)
+def cleanup_gpio():
+    global led
+    if led:
+        led.close()
+        led = None
 
-    for symbol in morse:
-        if symbol == '.':
-            send_dot()
-        elif symbol == '-':
-            send_dash()
+def write_led(level):
+    led.write(level)
 
-    # Space between letters (subtract symbol space since it was already added)
-    time.sleep(LETTER_SPACE - SYMBOL_SPACE)
+def send_message(message, repetitions):
+    # Compile once and print before the timed section
+    schedule = compile_message(message)
+    print(message_pattern(message))
+    play_schedule(schedule, DOT, write_led, repetitions)
 
-def send_message(message):
-    for char in message:
-        send_character(char)
-    print()  # New line after message
+def send_line(line, dot=DOT):
+    # Streaming: the trailing space puts a word gap before the next line
+    play_schedule(compile_message(line + ' '), dot, write_led)
 
 def main():
-    if len(sys.argv) < 3:
-        print("Usage: python3 morse_transmitter.py <repetitions> <message>")
-        print('Example: python3 morse_transmitter.py 4 "hello ESP32"')
-        sys.exit(1)
+    parser = argparse.ArgumentParser(description="Morse code transmitter",
+                                     epilog='Example: python3 morse_transmitter.py 4 "hello ESP32"')
+    parser.add_argument("repetitions", type=int, nargs="?", help="number of times to send the message")
+    parser.add_argument("message", nargs="?", help="text to send")
+    parser.add_argument("--stream", nargs="?", const="-", metavar="SOURCE",
+                        help="keep transmitting lines read from stdin (default) or a FIFO")
+    parser.add_argument("--queue-size", type=int, default=QUEUE_SIZE,
+                        help="lines buffered in stream mode (default %(default)d)")
+    parser.add_argument("--backend", choices=[name for name in BACKENDS if name != "pigpio"], default="gpio",
+                        help="LED output: RPi.GPIO (gpio), lgpio (any Pi, including the 5), GPIO registers "
+                             "(mmap, Pi 1-4) or a recorder (mock, no hardware); see morse_gpio.py")
+    parser.add_argument("--edges", metavar="PATH",
+                        help="mock backend: write the edges it recorded to PATH as CSV (t_us,level)")
+    args = parser.parse_args()
+
+    if args.stream:
+        print(f"Streaming lines from {'stdin' if args.stream == '-' else args.stream}")
+        try:
+            setup_gpio(args.backend, args.edges)
+            run_stream(args.stream, send_line, args.queue_size)
+        except KeyboardInterrupt:
+            print("\nTransmission interrupted by user")
+        except RuntimeError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+        finally:
+            cleanup_gpio()
+        return
 
-    try:
-        repetitions = int(sys.argv[1])
-        message = sys.argv[2]
-    except ValueError:
-        print("Error: First argument must be a number")
+    if args.repetitions is None or args.message is None:
+        parser.print_usage()
         sys.exit(1)
 
+    repetitions = args.repetitions
+    message = args.message
+
     if repetitions < 1:
         print("Error: Number of repetitions must be at least 1")
         sys.exit(1)
@@ -104,15 +88,17 @@ def main():
     print("Morse code pattern:")
 
     try:
-        setup_gpio()
+        setup_gpio(args.backend, args.edges)
 
-        for i in range(repetitions):
-            send_message(message)
+        send_message(message, repetitions)
 
         print("Transmission complete!")
 
     except KeyboardInterrupt:
         print("\nTransmission interrupted by user")
+    except RuntimeError as e:
+        print(f"Error: {e}")
+        sys.exit(1)
     finally:
         cleanup_gpio()
 
@@ -5,114 +5,396 @@ Morse Code Transmitter - Fast Mode (10 chars/sec)
 Transmits text messages as Morse code via LED on GPIO pin at high speed
 """
 
-import RPi.GPIO as GPIO
-import time
+import argparse
 import sys
 
+from morse_gpio import BACKENDS, open_backend
+from morse_schedule import WAKE_IDLE_S, WORD_SPACE_UNITS, WakePreamble, compile_message, message_pattern, play_schedule
+from morse_stream import QUEUE_SIZE, run_stream
+from morse_frame import Framer, printable
+from morse_code import TABLE_NAMES
+from morse_data import HALF_BIT_US, TRAILER_HALF_BITS, announce_schedule, bit_rate, data_pulses, split_bursts
+from morse_lanes import LaneFramer, lane_schedule, speedup
+
 # LED Configuration
-LED_PIN = 17  # GPIO pin number
+LED_PINS = [17]  # GPIO pin numbers; with several, framed payloads are striped across them (--pins)
+EDGES_PATH = None  # CSV the mock backend records its edges to (--edges)
+led = None       # Output backend of the software-timed player (morse_gpio.py)
 
 # Morse code timing (in seconds) - 10x faster for 10 chars/sec
 DOT = 0.01             # Duration of a dot (10ms)
-DASH = DOT * 3         # Duration of a dash (3 dots)
-SYMBOL_SPACE = DOT     # Space between dots and dashes within a character
-LETTER_SPACE = DOT * 3 # Space between letters
-WORD_SPACE = DOT * 7   # Space between words
-
-# Morse code dictionary
-MORSE_CODE = {
-    'A': '.-',    'B': '-...',  'C': '-.-.',  'D': '-..',   'E': '.',
-    'F': '..-.',  'G': '--.',   'H': '....',  'I': '..',    'J': '.---',
-    'K': '-.-',   'L': '.-..',  'M': '--',    'N': '-.',    'O': '---',
-    'P': '.--.',  'Q': '--.-',  'R': '.-.',   'S': '...',   'T': '-',
-    'U': '..-',   'V': '...-',  'W': '.--',   'X': '-..-',  'Y': '-.--',
-    'Z': '--..',
-    '0': '-----', '1': '.----', '2': '..---', '3': '...--', '4': '....-',
-    '5': '.....', '6': '-....', '7': '--...', '8': '---..', '9': '----.',
-    ' ': '/'  # Space between words
-}
-
-def setup_gpio():
-    GPIO.setmode(GPIO.BCM)
-    GPIO.setwarnings(False)
-    GPIO.setup(LED_PIN, GPIO.OUT)
-    GPIO.output(LED_PIN, GPIO.LOW)
+# Dashes and spaces are whole multiples of DOT (see morse_schedule.py)
+
+def setup_gpio(backend="gpio"):
+    global led
+    led = open_backend(backend, LED_PINS, EDGES_PATH)
 
 def cleanup_gpio():
-    GPIO.output(LED_PIN, GPIO.LOW)
-    GPIO.cleanup()
-
-def send_dot():
-    GPIO.output(LED_PIN, GPIO.HIGH)
-    time.sleep(DOT)
-    GPIO.output(LED_PIN, GPIO.LOW)
-    time.sleep(SYMBOL_SPACE)
-
-def send_dash():
-    GPIO.output(LED_PIN, GPIO.HIGH)
-    time.sleep(DASH)
-    GPIO.output(LED_PIN, GPIO.LOW)
-    time.sleep(SYMBOL_SPACE)
-
-def send_character(char):
-    char = char.upper()
-
-    if char == ' ':
-        # For space, wait word space duration
-        time.sleep(WORD_SPACE - LETTER_SPACE)  # Subtract letter space since it's added after each char
-        return
+    global led
+    if led:
+        led.close()
+        led = None
+
+def write_led(level):
+    # level is a lane mask: bit i drives LED_PINS[i] (0/1 is the first LED alone)
+    led.write(level)
+
+def send_message(message, repetitions, dot=DOT):
+    # Compile once and print before the timed section
+    schedule = compile_message(message)
+    print(message_pattern(message))
+    play_schedule(schedule, dot, write_led, repetitions)
+
+def send_line(line, dot=DOT):
+    # Streaming: the trailing space puts a word gap before the next line
+    play_schedule(compile_message(line + ' '), dot, write_led)
+
+def send_lanes(messages, repetitions, dot=DOT):
+    # All lanes from one merged schedule, so the LEDs stay in lockstep
+    play_schedule(lane_schedule(messages), dot, write_led, repetitions)
+
+def send_data(payload, repetitions, dot=DOT, half_bit_us=HALF_BIT_US):
+    # Software-timed Manchester bursts: use --backend pigpio below ~2 ms half bits
+    bursts = split_bursts(payload)
+    for _ in range(repetitions):
+        for burst in bursts:
+            play_schedule(announce_schedule(), dot, write_led)
+            play_schedule(burst, half_bit_us / 1000000, write_led)
+
+def send_wake(wake, dot=DOT):
+    play_schedule(wake.schedule(dot), dot, write_led)
+
+def with_wake(send, wake, send_preamble, trailing_dark_s, pending_s=lambda: 0.0):
+    # Preamble before any line that follows a pause long enough for the receiver to sleep.
+    # pending_s: output send() left queued, which is still to play when it returns
+    if wake is None:
+        return send
+
+    def send_after_preamble(line):
+        if wake.due():
+            send_preamble()
+        send(line)
+        wake.finished(trailing_dark_s - pending_s())
+    return send_after_preamble
+
+def stream(source, queue_size, backend, dot=DOT, framer=None, half_bit_us=None, wake=None):
+    # Framed streaming: every line becomes one or more frames. Lines are framed and
+    # compiled on run_stream()'s encoder thread while the line before plays.
+    encode = framer.frame if framer else (lambda line: line)
+    striped = isinstance(framer, LaneFramer)
+    # Lines end with a word gap, data bursts with their trailer
+    trailing_dark_s = TRAILER_HALF_BITS * half_bit_us / 1000000 if half_bit_us else WORD_SPACE_UNITS * dot
 
-    if char not in MORSE_CODE:
-        # Skip characters not in Morse code dictionary
+    if backend == "pigpio":
+        from morse_waveform import WaveformPipeline, lane_pulses, message_pulses
+
+        pipeline = WaveformPipeline(LED_PINS, dot)
+        dot_us = pipeline.dot_us
+        if half_bit_us:
+            pulses = lambda line: data_pulses(line.encode(), dot_us, half_bit_us)
+        elif striped:
+            pulses = lambda line: lane_pulses([lane + ' ' for lane in encode(line)], dot_us)
+        else:
+            pulses = lambda line: message_pulses(encode(line) + ' ', dot_us)
+        send = pipeline.play
+        if wake:
+            preamble = pipeline.resident(pipeline.prepare(wake.pulses(dot_us)))
+            send = with_wake(send, wake, lambda: pipeline.play(preamble), trailing_dark_s, pipeline.pending_s)
+        try:
+            run_stream(source, send, queue_size, encode=lambda line: pipeline.prepare(pulses(line)))
+            pipeline.drain()
+        finally:
+            print(f"[pipeline] {pipeline.waves} waves chained, {pipeline.idle_starts} started on a dark channel",
+                  file=sys.stderr, flush=True)
+            pipeline.close()
         return
 
-    morse = MORSE_CODE[char]
-    print(morse, end=' ', flush=True)
+    # Software timed: the player gets (schedule, unit_s) segments, ready to play
+    if half_bit_us:
+        segments = lambda line: [segment for burst in split_bursts(line.encode())
+                                 for segment in ((announce_schedule(), dot), (burst, half_bit_us / 1000000))]
+    elif striped:
+        segments = lambda line: [(lane_schedule([lane + ' ' for lane in encode(line)]), dot)]
+    else:
+        # The trailing space puts a word gap before the next line
+        segments = lambda line: [(compile_message(encode(line) + ' '), dot)]
+
+    def send(line_segments):
+        for schedule, unit_s in line_segments:
+            play_schedule(schedule, unit_s, write_led)
+    send = with_wake(send, wake, lambda: send_wake(wake, dot), trailing_dark_s)
+    try:
+        setup_gpio(backend)
+        run_stream(source, send, queue_size, encode=segments)
+    finally:
+        cleanup_gpio()
+
+def autobaud_keyer(backend, wake=None):
+    # key(text, dot) for the link-rate search, which changes the dot between calls
+    if backend == "pigpio":
+        from morse_waveform import WaveformTransmitter
+
+        transmitter = WaveformTransmitter(LED_PINS, DOT)
+
+        def play(text, dot):
+            transmitter.dot_us = int(round(dot * 1000000))
+            if wake and wake.due():
+                transmitter.send_pulses(wake.pulses(transmitter.dot_us))
+            transmitter.send(text + ' ')
+        return play, transmitter.close
+
+    setup_gpio(backend)
+
+    def play(text, dot):
+        if wake and wake.due():
+            send_wake(wake, dot)
+        send_line(text, dot)
+    return play, cleanup_gpio
+
+def run_autobaud(args, framer, wake, message=None, repetitions=1, data=None):
+    # Negotiate the rate with the receiver over its serial console, then send at it
+    from morse_autobaud import LinkMonitor, LinkRate, dot_ladder
+    from morse_transfer import FileSender
 
-    for symbol in morse:
-        if symbol == '.':
-            send_dot()
-        elif symbol == '-':
-            send_dash()
+    monitor = LinkMonitor(args.autobaud)
+    play, close = autobaud_keyer(args.backend, wake)
 
-    # Space between letters (subtract symbol space since it was already added)
-    time.sleep(LETTER_SPACE - SYMBOL_SPACE)
+    def key(text, dot):
+        play(text, dot)
+        if wake:
+            wake.finished(WORD_SPACE_UNITS * dot)
 
-def send_message(message):
-    for char in message:
-        send_character(char)
-    print()  # New line after message
+    try:
+        link = LinkRate(monitor, framer, key, dot_ladder(args.backend), args.max_fer, args.reprobe_s)
+        link.negotiate()
+        if data is not None:
+            sender = FileSender(link, args.window)
+            elapsed, frames = sender.send(data)
+            print(f"Sent {len(data)} bytes in {elapsed:.3f} s: {len(data) / elapsed:.1f} bytes/s goodput "
+                  f"({frames} frames, {sender.resent} resent), link at {link.dot * 1000:g} ms dots")
+            return
+        if args.stream:
+            run_stream(args.stream, link.send, args.queue_size)
+        else:
+            for _ in range(repetitions):
+                link.send(message)
+        ok, sent = link.settle()
+        print(f"Receiver reported {ok}/{sent} frame(s) OK, link at {link.dot * 1000:g} ms dots")
+    finally:
+        close()
+        monitor.close()
+
+def send_waveform(message, repetitions, dot=DOT, half_bit_us=None, wake=None):
+    # DMA-timed playback of the same compiled schedule; a list is one message per lane
+    from morse_waveform import WaveformTransmitter
+
+    transmitter = WaveformTransmitter(LED_PINS, dot)
+    try:
+        if wake and wake.due():
+            transmitter.send_pulses(wake.pulses(transmitter.dot_us))
+        if isinstance(message, list):
+            transmitter.send_lanes(message, repetitions)
+        elif half_bit_us:
+            transmitter.send_pulses(data_pulses(message.encode(), transmitter.dot_us, half_bit_us), repetitions)
+        else:
+            print(message_pattern(message))
+            transmitter.send(message, repetitions)
+    finally:
+        transmitter.close()
 
 def main():
-    if len(sys.argv) < 3:
-        print("Usage: python3 morse_transmitter_fast.py <repetitions> <message>")
-        print('Example: python3 morse_transmitter_fast.py 4 "hello ESP32"')
-        sys.exit(1)
+    parser = argparse.ArgumentParser(description="Morse code transmitter - FAST MODE",
+                                     epilog='Example: python3 morse_transmitter_fast.py 4 "hello ESP32"')
+    parser.add_argument("repetitions", type=int, nargs="?", help="number of times to send the message")
+    parser.add_argument("message", nargs="?", help="text to send")
+    parser.add_argument("--stream", nargs="?", const="-", metavar="SOURCE",
+                        help="keep transmitting lines read from stdin (default) or a FIFO")
+    parser.add_argument("--framed", action="store_true",
+                        help="send as CRC-checked frames (see morse_frame.py) instead of plain text")
+    parser.add_argument("--fec", action="store_true",
+                        help="framed, with Reed-Solomon coded payloads (see morse_fec.py)")
+    parser.add_argument("--table", choices=TABLE_NAMES, default=TABLE_NAMES[0],
+                        help="code table for frame payloads, e.g. the corpus-tuned 'telemetry' table (implies --framed)")
+    parser.add_argument("--data", action="store_true",
+                        help="send as Manchester data bursts (see morse_data.py) instead of Morse characters")
+    parser.add_argument("--half-bit-us", type=int, default=HALF_BIT_US,
+                        help="data mode half-bit time in microseconds (default %(default)d)")
+    parser.add_argument("--pins", default=",".join(str(pin) for pin in LED_PINS),
+                        help="comma-separated LED GPIO pins (default %(default)s); more than one stripes frames across them (implies --framed)")
+    parser.add_argument("--queue-size", type=int, default=QUEUE_SIZE,
+                        help="lines buffered in stream mode (default %(default)d)")
+    parser.add_argument("--backend", choices=list(BACKENDS), default="gpio",
+                        help="pigpio: DMA waveform (needs sudo pigpiod); the others are software timed through "
+                             "RPi.GPIO (gpio), lgpio (any Pi, including the 5), GPIO registers (mmap, Pi 1-4) "
+                             "or a recorder (mock, no hardware); see morse_gpio.py")
+    parser.add_argument("--edges", metavar="PATH",
+                        help="mock backend: write the edges it recorded to PATH as CSV (t_us,level)")
+    parser.add_argument("--dot-ms", type=float, default=DOT * 1000,
+                        help="dot duration in ms (default %(default)g; use --backend pigpio below ~10 ms)")
+    parser.add_argument("--wake-preamble-ms", type=float, default=0,
+                        help="light pulse sent first after an idle period, for receivers built with light sleep; "
+                             "must outlast their wake-up (default off)")
+    parser.add_argument("--wake-idle-ms", type=float, default=WAKE_IDLE_S * 1000,
+                        help="idle time after which the receiver expects a preamble, its MORSE_SLEEP_IDLE_MS "
+                             "(default %(default)g)")
+    parser.add_argument("--autobaud", metavar="PORT",
+                        help="negotiate the dot length with the receiver, reading its frame reports from its "
+                             "USB serial PORT (e.g. /dev/ttyACM0; needs pyserial); implies --framed, overrides --dot-ms")
+    parser.add_argument("--max-fer", type=float, default=0.1,
+                        help="autobaud: frame error rate to settle for before slowing down (default %(default)g)")
+    parser.add_argument("--reprobe-s", type=float, default=60,
+                        help="autobaud: error-free seconds before trying a faster rate (default %(default)g)")
+    parser.add_argument("--file", metavar="PATH",
+                        help="send a file as acknowledged chunks, resending only lost frames (needs --autobaud; "
+                             "see morse_transfer.py)")
+    parser.add_argument("--window", type=int, default=8,
+                        help="file transfer: chunk frames in flight before waiting for reports (default %(default)s)")
+    args = parser.parse_args()
+    global EDGES_PATH
+    EDGES_PATH = args.edges
 
+    if args.dot_ms <= 0:
+        print("Error: Dot duration must be positive")
+        sys.exit(1)
+    dot = args.dot_ms / 1000
     try:
-        repetitions = int(sys.argv[1])
-        message = sys.argv[2]
+        pins = [int(pin) for pin in args.pins.split(",")]
     except ValueError:
-        print("Error: First argument must be a number")
+        print("Error: --pins takes comma-separated GPIO numbers, e.g. 17,27,22")
+        sys.exit(1)
+    if len(set(pins)) != len(pins):
+        print("Error: --pins lists a pin twice")
+        sys.exit(1)
+    LED_PINS[:] = pins
+    lanes = len(pins)
+    framed = args.framed or args.fec or args.table != TABLE_NAMES[0] or lanes > 1 or bool(args.autobaud)
+    table = TABLE_NAMES.index(args.table)
+    if args.data and framed:
+        print("Error: --data bursts carry their own CRC and use one LED; drop --framed/--fec/--table/--pins")
+        sys.exit(1)
+    if args.half_bit_us <= 0:
+        print("Error: Half-bit time must be positive")
+        sys.exit(1)
+    half_bit_us = args.half_bit_us if args.data else None
+    if args.wake_preamble_ms < 0 or args.wake_idle_ms <= 0:
+        print("Error: --wake-preamble-ms must be positive (or 0 for none) and --wake-idle-ms positive")
         sys.exit(1)
+    wake = WakePreamble(args.wake_preamble_ms / 1000, args.wake_idle_ms / 1000, (1 << lanes) - 1) if args.wake_preamble_ms else None
+
+    if args.file and not args.autobaud:
+        print("Error: --file needs the receiver's reports; add --autobaud PORT")
+        sys.exit(1)
+    if args.autobaud:
+        if args.data or lanes > 1:
+            print("Error: --autobaud works on framed text over one LED; drop --data/--pins")
+            sys.exit(1)
+        if not 0 <= args.max_fer < 1 or args.reprobe_s <= 0:
+            print("Error: --max-fer must be in [0, 1) and --reprobe-s positive")
+            sys.exit(1)
+        if args.file:
+            if args.stream or args.repetitions is not None or args.window < 1:
+                print("Error: --file sends the file alone; drop --stream and the message, and keep --window >= 1")
+                sys.exit(1)
+            try:
+                with open(args.file, "rb") as f:
+                    data = f.read()
+            except OSError as e:
+                print(f"Error: {e}")
+                sys.exit(1)
+            print(f"Sending {args.file} ({len(data)} bytes) - FAST MODE, autobaud via {args.autobaud} ({args.backend})")
+            try:
+                run_autobaud(args, Framer(fec=args.fec, table=table), wake, data=data)
+            except KeyboardInterrupt:
+                print("\nTransmission interrupted by user")
+            except (RuntimeError, ValueError) as e:
+                print(f"Error: {e}")
+                sys.exit(1)
+            return
+        if not args.stream and (args.repetitions is None or args.message is None or args.repetitions < 1):
+            parser.print_usage()
+            sys.exit(1)
+        source = f"lines from {'stdin' if args.stream == '-' else args.stream}" if args.stream else f"'{args.message}'"
+        print(f"Sending {source} - FAST MODE, autobaud via {args.autobaud} ({args.backend})")
+        try:
+            run_autobaud(args, Framer(fec=args.fec, table=table), wake, args.message, args.repetitions or 1)
+        except KeyboardInterrupt:
+            print("\nTransmission interrupted by user")
+        except RuntimeError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+        return
+
+    if args.stream:
+        print(f"Streaming lines from {'stdin' if args.stream == '-' else args.stream} - FAST MODE ({args.dot_ms:g}ms dots, {args.backend})")
+        try:
+            framer = None
+            if lanes > 1:
+                framer = LaneFramer(lanes, fec=args.fec, table=table)
+            elif framed:
+                framer = Framer(fec=args.fec, table=table)
+            stream(args.stream, args.queue_size, args.backend, dot, framer, half_bit_us, wake)
+        except KeyboardInterrupt:
+            print("\nTransmission interrupted by user")
+        except RuntimeError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+        return
+
+    if args.repetitions is None or args.message is None:
+        parser.print_usage()
+        sys.exit(1)
+
+    repetitions = args.repetitions
+    message = args.message
 
     if repetitions < 1:
         print("Error: Number of repetitions must be at least 1")
         sys.exit(1)
 
-    print(f"Sending message '{message}' {repetitions} time(s) - FAST MODE (10 chars/sec)")
-    print("Morse code pattern:")
+    print(f"Sending message '{message}' {repetitions} time(s) - FAST MODE ({args.dot_ms:g}ms dots, {args.backend})")
+    if lanes > 1:
+        message = LaneFramer(lanes, fec=args.fec, table=table).frame(message)
+        for pin, lane in zip(pins, message):
+            print(f"GPIO{pin}: {printable(lane)}")
+        print(f"Striped over {lanes} LEDs: {speedup(message):.2f}x one LED")
+    elif framed:
+        message = Framer(fec=args.fec, table=table).frame(message)
+        print(f"Framed: {printable(message)}")
+    if args.data:
+        print(f"Data mode: {len(message.encode())} bytes at {bit_rate(args.half_bit_us):g} bit/s")
+    elif lanes == 1:
+        print("Morse code pattern:")
+
+    if args.backend == "pigpio":
+        try:
+            send_waveform(message, repetitions, dot, half_bit_us, wake)
+            print("Transmission complete!")
+        except KeyboardInterrupt:
+            print("\nTransmission interrupted by user")
+        except RuntimeError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+        return
 
     try:
-        setup_gpio()
+        setup_gpio(args.backend)
 
-        for i in range(repetitions):
-            send_message(message)
+        if wake:
+            send_wake(wake, dot)
+        if args.data:
+            send_data(message.encode(), repetitions, dot, args.half_bit_us)
+        elif lanes > 1:
+            send_lanes(message, repetitions, dot)
+        else:
+            send_message(message, repetitions, dot)
 
         print("Transmission complete!")
 
     except KeyboardInterrupt:
         print("\nTransmission interrupted by user")
+    except RuntimeError as e:
+        print(f"Error: {e}")
+        sys.exit(1)
     finally:
         cleanup_gpio()
 
@@ -0,0 +1,210 @@
+"""
+Author: Noah Laforet
+Hardware-timed Morse playback using pigpio DMA waveforms
+
+The compiled schedule from morse_schedule.py is scaled to pulses and handed
+to the pigpio daemon, which plays it out of DMA-paced memory. Edge timing no
+longer depends on the Linux scheduler, so jitter drops from milliseconds to a
+few microseconds and dots down to 1 ms become usable.
+
+Several LEDs can be driven from the same waveform (see morse_lanes.py):
+pulse levels are then lane masks, bit i being the LED on pins[i]. A plain
+0/1 level is lane 0 alone.
+
+WaveformPipeline, for streaming, never waits for the channel to go dark:
+each wave is built while the one before it plays and queued with
+WAVE_MODE_ONE_SHOT_SYNC, so DMA starts it on the edge the current wave ends.
+Back-to-back lines are then separated only by their own trailing gap.
+
+Requires the pigpio daemon: sudo pigpiod
+"""
+
+import collections
+import time
+
+import pigpio
+
+from morse_lanes import lane_schedule
+from morse_schedule import compile_message
+
+# pigpio limits the pulses per wave and the entries per chain, so long messages
+# are split into several waves and chained
+MAX_WAVE_PULSES = 1000
+MAX_CHAIN_WAVES = 100
+MAX_CHAIN_LOOPS = 65535
+
+# Pipeline: waves are built padded to a fixed share of pigpio's wave memory,
+# so a deleted wave's space always fits the next one. At most four exist: on
+# air, queued, being built, and a wake preamble kept for reuse.
+PIPELINE_WAVE_PULSES = 500
+PIPELINE_WAVE_PERCENT = 25
+# How often the player checks which wave is on air. A wave shorter than this
+# may end before the next is queued and leave a gap.
+POLL_S = 0.001
+
+
+def message_pulses(message, dot_us):
+    """Scale a message's compiled schedule to (level, duration_us) pulses."""
+    return [(level, units * dot_us) for level, units in compile_message(message)]
+
+
+def lane_pulses(messages, dot_us):
+    """(lanes, duration_us) pulses playing messages[i] on LED i in lockstep."""
+    return [(lanes, units * dot_us) for lanes, units in lane_schedule(messages)]
+
+
+class WaveformTransmitter:
+    def __init__(self, pins, dot_s):
+        self.pins = [pins] if isinstance(pins, int) else list(pins)
+        self.dot_us = int(round(dot_s * 1000000))
+        self.pi = pigpio.pi()
+        if not self.pi.connected:
+            raise RuntimeError("Cannot connect to pigpio daemon (start it with: sudo pigpiod)")
+
+        for pin in self.pins:
+            self.pi.set_mode(pin, pigpio.OUTPUT)
+        self._all_off()
+
+    def _all_off(self):
+        for pin in self.pins:
+            self.pi.write(pin, 0)
+
+    def _gpio_mask(self, lanes):
+        return sum(1 << pin for lane, pin in enumerate(self.pins) if lanes >> lane & 1)
+
+    def _add_pulses(self, pulses):
+        all_pins = self._gpio_mask(-1)
+        chunk = []
+        for lanes, us in pulses:
+            on = self._gpio_mask(lanes)
+            chunk.append(pigpio.pulse(on, all_pins & ~on, us))
+        self.pi.wave_add_generic(chunk)
+
+    def _create_waves(self, pulses):
+        waves = []
+        for start in range(0, len(pulses), MAX_WAVE_PULSES):
+            self._add_pulses(pulses[start:start + MAX_WAVE_PULSES])
+            waves.append(self.pi.wave_create())
+        return waves
+
+    def send(self, message, repetitions=1):
+        """Play a message back to back `repetitions` times and wait for it to finish."""
+        self.send_pulses(message_pulses(message, self.dot_us), repetitions)
+
+    def send_lanes(self, messages, repetitions=1):
+        """Play one message per LED in lockstep (messages[i] on pins[i])."""
+        if len(messages) > len(self.pins):
+            raise ValueError("More lanes than LED pins")
+        self.send_pulses(lane_pulses(messages, self.dot_us), repetitions)
+
+    def send_pulses(self, pulses, repetitions=1):
+        """Play (level, duration_us) pulses, e.g. a data burst from morse_data.py; levels are lane masks."""
+        if not pulses:
+            return
+
+        self.pi.wave_clear()
+        waves = self._create_waves(pulses)
+        if len(waves) > MAX_CHAIN_WAVES:
+            raise ValueError("Message too long for a single waveform chain")
+
+        try:
+            remaining = repetitions
+            while remaining > 0:
+                loops = min(remaining, MAX_CHAIN_LOOPS)
+                # 255 0 ... 255 1 x y: repeat the enclosed waves x + 256 * y times
+                self.pi.wave_chain([255, 0] + waves + [255, 1, loops & 0xFF, loops >> 8])
+                while self.pi.wave_tx_busy():
+                    time.sleep(0.01)
+                remaining -= loops
+        finally:
+            self.pi.wave_tx_stop()
+            self._all_off()
+            self.pi.wave_clear()
+
+    def close(self):
+        self.pi.wave_tx_stop()
+        self._all_off()
+        self.pi.stop()
+
+
+class WaveformPipeline(WaveformTransmitter):
+    """Gapless playback of a stream of messages: prepare() on one thread, play() on another.
+
+    prepare() is plain computation and can run on an encoder thread; every
+    pigpio call stays in play(). pigpio links a ONE_SHOT_SYNC wave to the end
+    of the wave on air and only one can wait there, so play() builds a wave
+    while the two before it are in DMA and queues it once the first of them
+    has finished. Don't mix with send(), which clears every wave.
+    """
+
+    def __init__(self, pins, dot_s):
+        super().__init__(pins, dot_s)
+        self.pi.wave_clear()
+        self._outstanding = collections.deque()     # Waves sent, oldest (on air) first
+        self._resident = set()                      # Waves kept for reuse
+        self._on_air_until = time.perf_counter()
+        self.waves = 0
+        self.idle_starts = 0        # Waves that found the channel dark: input paused, or the player was late
+
+    @staticmethod
+    def prepare(pulses):
+        """Split (level, duration_us) pulses into wave-sized parts: a chunk for play()."""
+        parts = [pulses[start:start + PIPELINE_WAVE_PULSES] for start in range(0, len(pulses), PIPELINE_WAVE_PULSES)]
+        return parts, sum(us for _, us in pulses) / 1000000
+
+    def resident(self, chunk):
+        """Build a chunk's waves once, to play() it any number of times."""
+        parts, duration_s = chunk
+        waves = [self._create_wave(part) for part in parts]
+        self._resident.update(waves)
+        return waves, duration_s
+
+    def _create_wave(self, pulses):
+        self._add_pulses(pulses)
+        return self.pi.wave_create_and_pad(PIPELINE_WAVE_PERCENT)
+
+    def _reap(self):
+        # Waves before the one on air have finished
+        at = self.pi.wave_tx_at()
+        if at == pigpio.NO_TX_WAVE:
+            done = len(self._outstanding)
+        elif at in self._outstanding:
+            done = self._outstanding.index(at)
+        else:
+            done = 0
+        for _ in range(done):
+            wave = self._outstanding.popleft()
+            if wave not in self._resident:
+                self.pi.wave_delete(wave)
+
+    def play(self, chunk):
+        """Queue a chunk behind whatever is playing; returns once its last wave is queued."""
+        parts, duration_s = chunk
+        for part in parts:
+            wave = part if isinstance(part, int) else self._create_wave(part)
+            self._reap()
+            while len(self._outstanding) > 1:
+                time.sleep(POLL_S)
+                self._reap()
+            if not self._outstanding:
+                self.idle_starts += 1
+            self.pi.wave_send_using_mode(wave, pigpio.WAVE_MODE_ONE_SHOT_SYNC)
+            self._outstanding.append(wave)
+            self.waves += 1
+        self._on_air_until = max(self._on_air_until, time.perf_counter()) + duration_s
+
+    def pending_s(self):
+        """Seconds of queued output still to play."""
+        return max(0.0, self._on_air_until - time.perf_counter())
+
+    def drain(self):
+        """Wait for everything queued to finish."""
+        while self.pi.wave_tx_busy():
+            time.sleep(POLL_S)
+        self._reap()
+
+    def close(self):
+        self.pi.wave_tx_stop()
+        self._all_off()
+        self.pi.wave_clear()
+        self.pi.stop()